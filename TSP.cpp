@@ -1,30 +1,47 @@
 // Traveling Salesman Problem Approximation Algorithm, by Wesley Junkins.
-// This algorithm takes as input the method to use (original, brute, nearest, check), the input graph, and optionally, the graph to check.
+// This algorithm takes as input the method to use (original, stream, brute, heldkarp, bnb, nearest, check), the input graph, and optionally, the paths to check.
 // Original mode uses my original algorithm, which will be described below.
+// Stream mode runs the original algorithm on text graphs too large for memory: it reads the file in chunks and only keeps the cheapest edges of every node (--candidates=K, lowered to fit --memory-limit=MB), then joins the leftover chains in further passes.
 // Brute mode runs the brute force algorithm for finding an exact answer to TSP.
+// Heldkarp mode finds the exact answer with the Held-Karp dynamic program, which handles graphs of up to about 25 nodes. Its table is sized before it is allocated, and graphs it would not fit for are refused (--memory-limit=MB, physical memory by default).
+// Bnb mode finds the exact answer by branch and bound on all threads, pruning with penalized 1-tree bounds. It handles graphs of up to 64 nodes; how long it takes depends on how tight the bounds are.
 // Nearest mode runs the nearest neighbor algorithm to find an approximation for TSP.
+// Improve mode improves the path in the .sol file given as the third argument with 2-opt and Or-opt moves. --improve does the same to the path of original or nearest mode before it is written.
+// --time-limit=SECONDS adds Lin-Kernighan style moves and keeps improving the path (by kicking and repairing it) until the time is up, saving the best path so far to the mode's .sol file every --checkpoint=SECONDS.
+// Batch mode runs every job of a manifest file (one "inputFile.ext mode --options" per line, for the original, nearest, brute, heldkarp and bnb modes) in one process: --jobs=J at a time, loading the next graphs while others are solved, within --memory-limit=MB. It writes each job's .sol file and a summary (--summary=FILE, batch_summary.csv by default).
+// Bench mode (which takes no input file) generates seeded graphs of several families and sizes, runs the solver modes on them a few times each and writes a report of the times, peak memory and distances (--report=FILE, bench_report.csv by default, or JSON). See runBench for its options.
+// Generate mode writes a seeded graph of the bench families to the file given as the second argument, as text, binary or points (--family=F, --nodes=N, --seed=S, --format=FORMAT; see runGenerate). It replaces graphMaker.py for large graphs.
+// Check mode loads the input graph once and checks every .sol file given after it, in parallel: each must visit every node exactly once and return to its first node. It prints a table of the distances and problems found, and fails if any path is not a tour.
+// Convert mode writes a binary copy of the input graph (inputFile.bgraph, or the name given as the third argument). Every mode opens binary graphs without parsing.
+// Options can be added anywhere as --name=value. --threads=N sets the number of worker threads. --candidates=K makes nearest mode use each node's K cheapest neighbors, which are cached next to the graph file (inputFile.ext.kK.cand).
+// --quiet prints only a summary (distance, node count, timings and the tour) in one write, and --json prints it as a JSON object. --verbose=N picks how much else is printed: 0 nothing, 1 progress messages, 2 (the default) also every connection and hop.
+// --stats prints how long each phase took and counters such as the edges the greedy loop scanned and accepted, as JSON (or writes them to --stats=FILE); --trace=FILE writes the phases as a Chrome trace-event file.
+// --starts=N makes nearest mode try N start nodes (or every node with --starts=all) in parallel and keep the shortest path. --no-simd turns off the AVX2/SSE4.1 row scan.
+// Graph files can also list one "x y" point per node instead of the weights. No matrix is built for them: distances are the Euclidean distances rounded to the nearest integer, computed when needed, and nearest mode (and the candidate lists) find nearby points with a grid. Original and stream mode join such points along each point's --candidates=K (16) nearest neighbors.
+// Graph files are memory-mapped and parsed by several threads at once. Compile with: g++ -O2 -std=c++17 -pthread TSP.cpp
+// crossCheck.sh builds this file and TSP_Brute_Force.cpp and checks on small seeded graphs that the exact modes agree, that improve, check and batch mode agree with them, and that every .sol file written is a valid tour.
 
 // Original algorithm description:
 /*
     Say you have a fully connected non-directional graph. You input this graph as a file of edge weights. Each row and column corresponds to a node-connection.
     This algorithm reads-in the graph file and builds a graph class containing nodes, connections, and weights.
-    After reading-in the file and determining the overall structure (arbitrarily) of the graph, all the edge weights are sorted.
+    After reading-in the file and determining the overall structure (arbitrarily) of the graph, all the edge weights are sorted. Equal weights keep their order in the matrix (row by row), so the same graph always gives the same path.
     Imagine an empty graph. We first start with the smallest edge-weight in our sorted list. We find the nodes that are connected by that edge weight and make that connection.
     Then, we move on to the next smallest edge weight.
     We continue this process, but we must follow some rules before adding a connection to the graph.
-    Each node has a node type: untouched, leader, inside. The state of the node, along with its group number, determine if a connection will be made.
+    Each node has a node type: untouched, leader, inside. The state of the node, along with its group, determine if a connection will be made. Groups are kept in a disjoint-set (union-find) structure.
     Say the next smallest edge weight in the list is X. So, we find the nodes that X would connect and look at their type and group.
     Cases:
         Both nodes are untouched:
-            Make the connection and label it with a new group number. The untouched nodes are now leader nodes.
+            Make the connection and put both nodes in one new group. The untouched nodes are now leader nodes.
         Both nodes are leaders:
-            Check if they are in the same group. If they are, do nothing. If not, make the connection and set the group of all the nodes connected to the two leader nodes to be the lower of the two group numbers. The leader nodes are now inside nodes.
+            Check if they are in the same group. If they are, do nothing. If not, make the connection and merge the two groups. The leader nodes are now inside nodes.
         One is a leader and one is untouched:
-            Make the connection. The untouched becomes a leader and the leader becomes an insider. The untouched node receives the group number of the leader's group.
+            Make the connection. The untouched becomes a leader and the leader becomes an insider. The untouched node joins the leader's group.
 
         There are other cases, but we do nothing in those scenarios.
 
-    When we have exhausted the edge weights, we are done constructing the graph. We can then retrace our steps to print what path we took.
+    Once n - 1 connections have been made (or we have exhausted the edge weights), we are done constructing the graph; the weights are sorted lazily in batches, so most of them never need sorting at all. We can then retrace our steps to print what path we took.
     The output is printed to the console as well as a file. The total distance is printed to the console and will appear in the filename.
 */
 
@@ -35,561 +52,5294 @@
 #include <vector>
 #include <algorithm>
 #include <cstring>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <array>
+#include <chrono>
+#include <random>
+#include <memory>
+#include <limits>
+#include <iomanip>
+#include <charconv>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 using namespace std;
 
-int globalGroupNumber = 1;
-int globalTotalWeight = 0;
+long long globalTotalWeight = 0;
+
+// The number of worker threads used by the parallel phases (parsing, etc.).
+int globalThreadCount = max(1, (int)thread::hardware_concurrency());
+
+// Batch mode runs several jobs at once and gives each job's thread a share of the workers; 0 means no limit. The worker indices handed out stay below globalThreadCount either way.
+thread_local int globalJobThreads = 0;
+
+// Returns the number of worker threads a parallel phase started from this thread may use.
+int activeThreadCount()
+{
+    return (globalJobThreads > 0) ? min(globalJobThreads, globalThreadCount) : globalThreadCount;
+};
+
+// How much the program prints: 0 prints only the result (--quiet, and --json unless --verbose is given), 1 adds the progress messages, and 2 (the default) also traces every connection and hop. Set with --verbose=N.
+int globalVerbosity = 2;
+
+// Batch jobs run quietly, whatever the verbosity.
+thread_local bool globalQuietThread = false;
+
+// Returns the stream for messages of the given verbosity level: cout if they are wanted, otherwise a stream that drops everything.
+ostream &progress(int level = 1)
+{
+    thread_local ostream discard(nullptr);
+    return (globalQuietThread || (globalVerbosity < level)) ? discard : cout;
+};
+
+// When the program started and when it finished loading its input, for the summary.
+chrono::steady_clock::time_point globalStartTime = chrono::steady_clock::now();
+chrono::steady_clock::time_point globalLoadedTime = globalStartTime;
+
+// Stream mode reads its file during the passes rather than before them, so it has no load time of its own; the summary leaves it out and counts the whole run as solving.
+bool globalLoadOverlapped = false;
+
+// Instrumentation, turned on by --stats or --trace=FILE. While it is off, every timer and counter below costs a single well-predicted branch.
+bool globalStatsEnabled = false;
+
+// The counters. Callers add to them in bulk (per block, batch, tour or task), never per item, so even when they are on they stay off the hot paths.
+enum statCounter
+{
+    tokensParsed,       // Numbers read from graph files.
+    edgesScanned,       // Edges the greedy loops looked at.
+    edgesAccepted,      // Edges the greedy loops turned into connections.
+    groupMerges,        // Groups merged by the disjoint sets.
+    groupRelabels,      // Nodes pointed at a new group representative by path compression.
+    nearestEvaluations, // Distances nearest neighbor compared.
+    bruteTours,         // Complete tours brute force added up.
+    numStatCounters
+};
+const char *statCounterNames[numStatCounters] = {"tokens_parsed", "edges_scanned", "edges_accepted", "group_merges", "group_relabels", "nearest_evaluations", "brute_tours"};
+atomic<uint64_t> globalStatCounters[numStatCounters];
+
+// Adds to a counter if instrumentation is on.
+inline void countStat(statCounter counter, uint64_t amount)
+{
+    if (globalStatsEnabled)
+    {
+        globalStatCounters[counter].fetch_add(amount, memory_order_relaxed);
+    };
+};
+
+// One timed phase: its name, when it started and how long it took (microseconds since the program started), and the thread that ran it.
+struct traceEvent
+{
+    const char *name;
+    double start;
+    double duration;
+    int thread;
+};
+mutex globalTraceLock;
+vector<traceEvent> globalTraceEvents;
+
+// Returns a small number that names the calling thread in the trace.
+int traceThreadId()
+{
+    static atomic<int> nextId(0);
+    thread_local int id = nextId++;
+    return id;
+};
+
+// Times the scope it is declared in as one phase, and records it when the scope ends.
+class scopedTimer
+{
+public:
+    const char *name;
+    chrono::steady_clock::time_point start;
+
+    // Default constructor. The name must be a string literal, since only the pointer is kept.
+    scopedTimer(const char *name)
+    {
+        this->name = name;
+        if (globalStatsEnabled)
+        {
+            this->start = chrono::steady_clock::now();
+        };
+    };
+
+    ~scopedTimer()
+    {
+        if (globalStatsEnabled)
+        {
+            auto end = chrono::steady_clock::now();
+            traceEvent event = {this->name, chrono::duration<double, micro>(this->start - globalStartTime).count(), chrono::duration<double, micro>(end - this->start).count(), traceThreadId()};
+            lock_guard<mutex> guard(globalTraceLock);
+            globalTraceEvents.push_back(event);
+        };
+    };
+};
+
+// Runs work(worker, task) for every task in [0, count) on a pool of worker threads (worker is in [0, globalThreadCount)). Workers take the next task from a shared counter as soon as they are free, so uneven tasks still keep every thread busy.
+void parallelTasks(size_t count, const function<void(int, size_t)> &work)
+{
+    atomic<size_t> nextTask(0);
+    auto runWorker = [&](int worker)
+    {
+        for (size_t task = nextTask++; task < count; task = nextTask++)
+        {
+            work(worker, task);
+        };
+    };
+    int numThreads = min((size_t)activeThreadCount(), count);
+    if (numThreads <= 1)
+    {
+        runWorker(0);
+        return;
+    };
+    vector<thread> workers;
+    for (int w = 0; w < numThreads; w++)
+    {
+        workers.emplace_back(runWorker, w);
+    };
+    for (int w = 0; w < numThreads; w++)
+    {
+        workers.at(w).join();
+    };
+};
+
+// The command-line options, given as --name=value (or just --name) anywhere on the command line.
+map<string, string> globalOptions;
+
+// The options of the batch job running on this thread, which take precedence over the command line's.
+thread_local const map<string, string> *globalJobOptions = nullptr;
+
+// Returns an option's value, or nullptr if it was not given.
+const string *findOption(const string &name)
+{
+    if ((globalJobOptions != nullptr) && (globalJobOptions->count(name) > 0))
+    {
+        return &globalJobOptions->at(name);
+    };
+    auto option = globalOptions.find(name);
+    return (option == globalOptions.end()) ? nullptr : &option->second;
+};
+
+// Returns true if an option was given.
+bool hasOption(const string &name)
+{
+    return findOption(name) != nullptr;
+};
+
+// Returns an option's value as an integer, or defaultValue if it was not given.
+int getIntOption(const string &name, int defaultValue)
+{
+    if (!hasOption(name) || findOption(name)->empty())
+    {
+        return defaultValue;
+    };
+    return atoi(findOption(name)->c_str());
+};
+
+// Returns an option's value as a number, or defaultValue if it was not given.
+double getDoubleOption(const string &name, double defaultValue)
+{
+    if (!hasOption(name) || findOption(name)->empty())
+    {
+        return defaultValue;
+    };
+    return atof(findOption(name)->c_str());
+};
+
+// Returns the memory a mode may use, in bytes: --memory-limit=MB, or the machine's physical memory.
+uint64_t getMemoryLimit()
+{
+    if (hasOption("memory-limit"))
+    {
+        return (uint64_t)(getDoubleOption("memory-limit", 0) * 1024 * 1024);
+    };
+    return (uint64_t)sysconf(_SC_PHYS_PAGES) * sysconf(_SC_PAGE_SIZE);
+};
+
+// Splits the range [0, count) into one contiguous block per worker thread and runs the given function on each block in parallel.
+void parallelFor(size_t count, const function<void(size_t, size_t)> &work)
+{
+    size_t numThreads = min((size_t)activeThreadCount(), count);
+    if (numThreads <= 1)
+    {
+        work(0, count);
+        return;
+    };
+    vector<thread> workers;
+    for (size_t t = 0; t < numThreads; t++)
+    {
+        size_t begin = count * t / numThreads;
+        size_t end = count * (t + 1) / numThreads;
+        workers.emplace_back(work, begin, end);
+    };
+    for (int t = 0; t < workers.size(); t++)
+    {
+        workers.at(t).join();
+    };
+};
 
 class node
 {
 public:
     int nodeName;    // The integer name of a node, starting with 0.
     int nodeType;    // The type of node it is: 0 = untouched, 1 = leader, 2 = inside.
-    int nodeGroup;   // The group that the node is in. Starts with 0, but changes to the global group number as soon as it is touched.
-    bool wasTouched; // Only used in nearest neighbor algorithm.
 
     // Default constructor
     node(int nodeName)
     {
         this->nodeName = nodeName;
         this->nodeType = 0;
-        this->nodeGroup = 0;
-        this->wasTouched = false;
     };
 };
 
-class connectedNode
+// The groups of the original algorithm, kept as a disjoint-set forest with union by rank and path compression. Merging two groups and asking which group a node is in both take nearly constant time.
+class disjointSet
+{
+public:
+    vector<int> parent;
+    vector<int> rank;
+
+    // How many groups have been merged, and how many nodes path compression has pointed at a new representative (for --stats).
+    uint64_t merges;
+    uint64_t relabels;
+
+    // Default constructor. Every node starts in a group of its own.
+    disjointSet(int numNodes)
+    {
+        this->merges = 0;
+        this->relabels = 0;
+        this->parent.resize(numNodes);
+        this->rank.assign(numNodes, 0);
+        for (int i = 0; i < numNodes; i++)
+        {
+            this->parent[i] = i;
+        };
+    };
+
+    // Returns the representative of the node's group, pointing every node on the way straight at it.
+    int find(int nodeIndex)
+    {
+        int root = nodeIndex;
+        while (this->parent[root] != root)
+        {
+            root = this->parent[root];
+        };
+        while (this->parent[nodeIndex] != root)
+        {
+            int next = this->parent[nodeIndex];
+            this->parent[nodeIndex] = root;
+            this->relabels++;
+            nodeIndex = next;
+        };
+        return root;
+    };
+
+    // Adds the merges and relabels so far to the --stats counters.
+    void countStats() const
+    {
+        countStat(groupMerges, this->merges);
+        countStat(groupRelabels, this->relabels);
+    };
+
+    // Merges the groups of two nodes. The shallower tree is hung under the deeper one.
+    void unite(int a, int b)
+    {
+        a = find(a);
+        b = find(b);
+        if (a == b)
+        {
+            return;
+        };
+        if (this->rank[a] < this->rank[b])
+        {
+            swap(a, b);
+        };
+        this->parent[b] = a;
+        this->merges++;
+        if (this->rank[a] == this->rank[b])
+        {
+            this->rank[a]++;
+        };
+    };
+};
+
+// A read-only memory mapping of an entire file. The mapping is released when the object is destroyed.
+class mappedFile
 {
 public:
-    node *connectedLeftNode;
-    node *connectedRightNode;
-    bool checked;
+    const char *data;
+    size_t size;
 
     // Default constructor
-    connectedNode(node *connectedLeftNode, node *connectedRightNode)
+    mappedFile()
     {
-        this->connectedLeftNode = connectedLeftNode;
-        this->connectedRightNode = connectedRightNode;
-        this->checked = false;
-    }
+        this->data = nullptr;
+        this->size = 0;
+    };
+
+    ~mappedFile()
+    {
+        if (this->data != nullptr)
+        {
+            munmap((void *)this->data, this->size);
+        };
+    };
+
+    // Maps the file into memory. Returns false if it cannot be opened or mapped.
+    bool open(const char *fileName)
+    {
+        int fileDescriptor = ::open(fileName, O_RDONLY);
+        if (fileDescriptor < 0)
+        {
+            return false;
+        };
+        struct stat fileInfo;
+        if (fstat(fileDescriptor, &fileInfo) != 0)
+        {
+            ::close(fileDescriptor);
+            return false;
+        };
+        this->size = fileInfo.st_size;
+        if (this->size > 0)
+        {
+            void *mapping = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+            if (mapping == MAP_FAILED)
+            {
+                ::close(fileDescriptor);
+                return false;
+            };
+            this->data = (const char *)mapping;
+        };
+        ::close(fileDescriptor);
+        return true;
+    };
+
+    // Tells the kernel the file will be read front to back, so it can read ahead aggressively.
+    void adviseSequential()
+    {
+        if (this->data != nullptr)
+        {
+            madvise((void *)this->data, this->size, MADV_SEQUENTIAL);
+        };
+    };
 };
 
-class weight
+class graph
 {
 public:
-    int value;
-    int fromNode;
-    int toNode;
+    int numNodes;
+
+    // The Adjacency Matrix. Only the lower triangle without the diagonal is kept, row after row in one contiguous buffer, so the distance between i and j (j < i) is at triangleIndex(i, j).
+    // The weights are stored as uint16 when they all fit (weightWidth 2, as with graphMaker's 1..1000), otherwise as uint32 (weightWidth 4). Only the matching pointer is set.
+    int weightWidth;
+    const uint16_t *matrix16;
+    const uint32_t *matrix32;
+
+    // The buffers behind the matrix, unless it points straight into a mapped binary graph file.
+    vector<uint16_t> storage16;
+    vector<uint32_t> storage32;
+    unique_ptr<mappedFile> mapping;
+
+    // Coordinate graphs (a file of "x y" points) keep the points instead of a matrix: node i is at (xCoords[i], yCoords[i]), and a distance is the Euclidean distance rounded to the nearest integer, computed whenever it is needed.
+    bool coordinates;
+    vector<double> xCoords;
+    vector<double> yCoords;
+
+    // The vector of nodes. This will be useful in keeping up with the current state of each node (e.g. which group they are in.).
+    vector<node *> nodes;
+
+    // The node connections we make, two slots per node: connections[2 * i] and connections[2 * i + 1] are the nodes connected to node i, or -1 while a slot is empty. This will be useful when we need to retrace our path.
+    vector<int> connections;
+
+    // The vector of integers showing what path we took.
+    vector<int> pathTaken;
+
+    // Default constructor
+    graph()
+    {
+        this->numNodes = 0;
+        this->weightWidth = 2;
+        this->matrix16 = nullptr;
+        this->matrix32 = nullptr;
+        this->coordinates = false;
+    };
+
+    // Destructor
+    ~graph()
+    {
+        for (int i = 0; i < this->nodes.size(); i++)
+        {
+            delete this->nodes.at(i);
+        };
+    };
+
+    // Returns where the distance between nodes `row` and `column` (column < row) lives in the matrix.
+    static size_t triangleIndex(size_t row, size_t column)
+    {
+        return row * (row - 1) / 2 + column;
+    };
+
+    // Returns the number of stored weights for a graph with the given number of nodes.
+    static size_t triangleSize(size_t numNodes)
+    {
+        return numNodes * (numNodes - 1) / 2;
+    };
+
+    // Allocates an owned matrix of the given width for numNodes nodes. The loaders fill it in afterwards.
+    void allocateMatrix(int numNodes, int weightWidth)
+    {
+        this->numNodes = numNodes;
+        this->weightWidth = weightWidth;
+        this->matrix16 = nullptr;
+        this->matrix32 = nullptr;
+        this->storage16.clear();
+        this->storage32.clear();
+        if (weightWidth == 2)
+        {
+            this->storage16.resize(triangleSize(numNodes));
+            this->matrix16 = this->storage16.data();
+        }
+        else
+        {
+            this->storage32.resize(triangleSize(numNodes));
+            this->matrix32 = this->storage32.data();
+        };
+    };
+
+    // Records a connection between two nodes in the first free slot of each. Every node gets at most two connections.
+    void connect(int a, int b)
+    {
+        this->connections[2 * a + (this->connections[2 * a] != -1)] = b;
+        this->connections[2 * b + (this->connections[2 * b] != -1)] = a;
+    };
+
+    // Walks the cycle of connections starting at startNode, writing numNodes + 1 nodes (back to startNode) into pathTaken. The first step follows startNode's first connection. O(n).
+    void retracePath(int startNode)
+    {
+        this->pathTaken.resize(this->numNodes + 1);
+        int previousNode = -1;
+        int currentNode = startNode;
+        for (int i = 0; i < this->numNodes; i++)
+        {
+            this->pathTaken[i] = currentNode;
+            int nextNode = this->connections[2 * currentNode];
+            if ((nextNode == previousNode) || (nextNode == -1))
+            {
+                nextNode = this->connections[2 * currentNode + 1];
+            };
+            previousNode = currentNode;
+            currentNode = nextNode;
+        };
+        this->pathTaken[this->numNodes] = startNode;
+    };
+
+    // Creates the node objects once the number of nodes is known.
+    void createNodes()
+    {
+        this->nodes.reserve(this->numNodes);
+        for (int i = 0; i < this->numNodes; i++)
+        {
+            node *newNode = new node(i);
+            this->nodes.push_back(newNode);
+        };
+    };
+
+    // Returns the weight stored at a position of the matrix.
+    inline int weightAt(size_t index) const
+    {
+        return (this->weightWidth == 2) ? this->matrix16[index] : this->matrix32[index];
+    };
+
+    // Writes the distances from a node to every node (0 to itself) into row, which must hold numNodes values. The first part of the row is one contiguous run of the matrix; the rest is gathered down a column.
+    void gatherRow(int nodeIndex, uint32_t *row) const
+    {
+        if (this->coordinates)
+        {
+            for (int j = 0; j < this->numNodes; j++)
+            {
+                row[j] = pointDistance(nodeIndex, j);
+            };
+            return;
+        };
+        size_t rowStart = triangleIndex(nodeIndex, 0);
+        for (int j = 0; j < nodeIndex; j++)
+        {
+            row[j] = weightAt(rowStart + j);
+        };
+        row[nodeIndex] = 0;
+        for (int j = nodeIndex + 1; j < this->numNodes; j++)
+        {
+            row[j] = weightAt(triangleIndex(j, nodeIndex));
+        };
+    };
+
+    // Returns the rounded Euclidean distance between two nodes of a coordinate graph.
+    inline int pointDistance(int from, int to) const
+    {
+        double dx = this->xCoords[from] - this->xCoords[to];
+        double dy = this->yCoords[from] - this->yCoords[to];
+        return (int)(sqrt(dx * dx + dy * dy) + 0.5);
+    };
+
+    // Looks-up the distance from a node to a node. The two nodes must be different. There are no bounds checks, as every algorithm calls this in its innermost loop.
+    inline int distance(int from, int to) const
+    {
+        if (this->coordinates)
+        {
+            return pointDistance(from, to);
+        };
+        return (from > to) ? weightAt(triangleIndex(from, to)) : weightAt(triangleIndex(to, from));
+    };
+
+    // The edges of the original algorithm are sorted as 64-bit keys: the weight in the high 32 bits and the edge's matrix index in the low 32 bits. Sorting the keys sorts by weight (ties by position in the matrix) without touching anything else.
+    // The largest graph whose matrix indices fit in the low half of an edge key.
+    static const int maxEdgeKeyNodes = 92682;
+
+    // Packs a weight and the matrix index of its edge into one sortable key.
+    static uint64_t edgeKey(uint32_t weightValue, size_t index)
+    {
+        return ((uint64_t)weightValue << 32) | (uint64_t)index;
+    };
+
+    // Returns the weight held in an edge key.
+    static int edgeWeight(uint64_t key)
+    {
+        return (int)(key >> 32);
+    };
+
+    // Returns the two nodes (row > column) that the edge at a matrix index connects.
+    static void edgeNodes(uint64_t key, int &row, int &column)
+    {
+        size_t index = (uint32_t)key;
+        size_t r = (size_t)((1.0 + sqrt(1.0 + 8.0 * (double)index)) / 2.0);
+        while (triangleIndex(r, 0) > index)
+        {
+            r--;
+        };
+        while (triangleIndex(r + 1, 0) <= index)
+        {
+            r++;
+        };
+        row = r;
+        column = index - triangleIndex(r, 0);
+    };
+
+    // Prints the weight-matrix that was read-in from the file.
+    void printMatrix()
+    {
+        for (int i = 0; i < this->numNodes; i++)
+        {
+            for (int j = 0; j < i; j++)
+            {
+                progress() << distance(i, j) << "\t";
+            };
+            progress() << 0 << '\n';
+        };
+    };
+
+    // The widest weight range (max - min + 1) that is sorted with a single counting pass. Wider ranges use the radix sort.
+    static const uint32_t countingSortRange = 1 << 16;
+
+    // Sorts a list of edge keys by weight.
+    // The keys must be in matrix order, so a stable sort on the weight alone gives the same order as sorting the whole keys. Equal weights therefore stay in matrix order; builds before the packed keys used an unstable std::sort, so their original-mode tours on graphs with tied weights are not reproduced. Small weight ranges (graphMaker emits 1..1000) take one counting pass; wider ranges take a least-significant-digit radix sort over the weight bits, 11 bits per pass. Both run on all threads.
+    static void sortWeghts(vector<uint64_t> &edgeKeys)
+    {
+        if (edgeKeys.empty())
+        {
+            return;
+        };
+        uint32_t minWeight = UINT32_MAX;
+        uint32_t maxWeight = 0;
+        for (size_t i = 0; i < edgeKeys.size(); i++)
+        {
+            uint32_t value = edgeKeys[i] >> 32;
+            minWeight = min(minWeight, value);
+            maxWeight = max(maxWeight, value);
+        };
+        uint32_t range = maxWeight - minWeight;
+        int rangeBits = 0;
+        while ((rangeBits < 32) && ((range >> rangeBits) != 0))
+        {
+            rangeBits++;
+        };
+        if (rangeBits == 0)
+        {
+            return;
+        };
+
+        vector<uint64_t> scratch(edgeKeys.size());
+        int digitBits = ((uint64_t)range < countingSortRange) ? rangeBits : 11;
+        for (int shift = 0; shift < rangeBits; shift += digitBits)
+        {
+            sortPass(edgeKeys, scratch, minWeight, shift, min(digitBits, rangeBits - shift));
+            edgeKeys.swap(scratch);
+        };
+    };
 
-    // Default constructor.
-    weight(int value, int fromNode, int toNode)
+    // One stable counting pass of the edge sort: scatters `in` into `out` by the digit ((weight - minWeight) >> shift) of width digitBits.
+    // Every thread counts the digits of its own chunk; the bucket offsets are then laid out bucket by bucket and chunk by chunk, so each thread can scatter its chunk independently and the pass stays stable.
+    static void sortPass(const vector<uint64_t> &in, vector<uint64_t> &out, uint32_t minWeight, int shift, int digitBits)
+    {
+        size_t numBuckets = (size_t)1 << digitBits;
+        uint32_t mask = numBuckets - 1;
+        size_t numChunks = min((size_t)globalThreadCount, in.size());
+        vector<vector<size_t>> counts(numChunks, vector<size_t>(numBuckets, 0));
+        parallelFor(numChunks, [&](size_t firstChunk, size_t lastChunk)
+                    {
+            for (size_t c = firstChunk; c < lastChunk; c++)
+            {
+                size_t *chunkCounts = counts[c].data();
+                for (size_t i = in.size() * c / numChunks; i < in.size() * (c + 1) / numChunks; i++)
+                {
+                    chunkCounts[(((uint32_t)(in[i] >> 32) - minWeight) >> shift) & mask]++;
+                };
+            }; });
+        size_t offset = 0;
+        for (size_t bucket = 0; bucket < numBuckets; bucket++)
+        {
+            for (size_t c = 0; c < numChunks; c++)
+            {
+                size_t bucketCount = counts[c][bucket];
+                counts[c][bucket] = offset;
+                offset += bucketCount;
+            };
+        };
+        parallelFor(numChunks, [&](size_t firstChunk, size_t lastChunk)
+                    {
+            for (size_t c = firstChunk; c < lastChunk; c++)
+            {
+                size_t *chunkOffsets = counts[c].data();
+                for (size_t i = in.size() * c / numChunks; i < in.size() * (c + 1) / numChunks; i++)
+                {
+                    out[chunkOffsets[(((uint32_t)(in[i] >> 32) - minWeight) >> shift) & mask]++] = in[i];
+                };
+            }; });
+    };
+};
+
+// Hands out the edges of a graph in sorted order, one batch at a time, so that the greedy loop can stop long before every edge has been sorted.
+// Each batch holds every nonzero edge whose weight lies in (lowerWeight, upperWeight]. The upper bound is picked from a histogram of all weights (uint16 matrices) or from a random sample of them (uint32 matrices) so that the batch holds about batchTarget edges, and the target grows fourfold with every batch.
+// Edges that touch an inside node are left out of every batch, since the greedy loop would never take them. Later batches therefore skip most rows of the matrix.
+// Equal weights always land in the same batch, and a batch is collected in matrix order and sorted with graph::sortWeghts, so the edges that can still be taken come out in exactly the order a full sort would give.
+class edgeBatches
+{
+public:
+    graph *myGraph;
+    uint32_t lowerWeight;   // Every edge up to this weight has been handed out.
+    bool exhausted;         // Set once the heaviest edge has been handed out.
+    size_t batchTarget;     // Roughly how many edges the next batch should hold.
+    uint32_t maxWeight;     // The heaviest weight in the graph.
+    size_t numEdges;        // The number of nonzero edges in the graph.
+    size_t edgesHandedOut;  // The number of edges handed out (and sorted) so far.
+    vector<size_t> histogram; // The number of edges of each weight (uint16 matrices only).
+    vector<uint32_t> sample;  // A sorted sample of the nonzero weights (uint32 matrices only).
+
+    // The number of weights sampled to pick batch bounds for uint32 matrices.
+    static const size_t sampleSize = 1 << 16;
+
+    // Default constructor. The first batch aims for a few edges per node; that is usually enough to join most of the nodes.
+    edgeBatches(graph *myGraph)
+    {
+        this->myGraph = myGraph;
+        this->lowerWeight = 0;
+        this->exhausted = false;
+        this->batchTarget = 4 * (size_t)myGraph->numNodes;
+        this->maxWeight = 0;
+        this->numEdges = 0;
+        this->edgesHandedOut = 0;
+        size_t numWeights = graph::triangleSize(myGraph->numNodes);
+        if (myGraph->weightWidth == 2)
+        {
+            size_t numChunks = max((size_t)1, min((size_t)globalThreadCount, numWeights));
+            vector<vector<size_t>> counts(numChunks, vector<size_t>(UINT16_MAX + 1, 0));
+            parallelFor(numChunks, [&](size_t firstChunk, size_t lastChunk)
+                        {
+                for (size_t c = firstChunk; c < lastChunk; c++)
+                {
+                    size_t *chunkCounts = counts[c].data();
+                    for (size_t i = numWeights * c / numChunks; i < numWeights * (c + 1) / numChunks; i++)
+                    {
+                        chunkCounts[myGraph->matrix16[i]]++;
+                    };
+                }; });
+            this->histogram.assign(UINT16_MAX + 1, 0);
+            for (size_t c = 0; c < numChunks; c++)
+            {
+                for (size_t w = 1; w <= UINT16_MAX; w++)
+                {
+                    this->histogram[w] += counts[c][w];
+                };
+            };
+            for (size_t w = 1; w <= UINT16_MAX; w++)
+            {
+                this->numEdges += this->histogram[w];
+                if (this->histogram[w] != 0)
+                {
+                    this->maxWeight = w;
+                };
+            };
+        }
+        else
+        {
+            // Sample with a fixed linear congruential generator so that runs are repeatable.
+            uint64_t state = 88172645463325252ULL;
+            for (size_t i = 0; (numWeights > 0) && (i < sampleSize); i++)
+            {
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+                uint32_t value = myGraph->matrix32[(state >> 16) % numWeights];
+                if (value != 0)
+                {
+                    this->sample.push_back(value);
+                };
+            };
+            sort(this->sample.begin(), this->sample.end());
+            for (size_t i = 0; i < numWeights; i++)
+            {
+                this->numEdges += (myGraph->matrix32[i] != 0);
+                this->maxWeight = max(this->maxWeight, myGraph->matrix32[i]);
+            };
+        };
+        this->exhausted = (this->numEdges == 0);
+    };
+
+    // Picks the upper weight of the next batch so that it holds about batchTarget edges.
+    uint32_t chooseUpperWeight()
+    {
+        if (!this->histogram.empty())
+        {
+            size_t batchCount = 0;
+            uint32_t upperWeight = this->lowerWeight;
+            while ((upperWeight < UINT16_MAX) && (batchCount < this->batchTarget))
+            {
+                upperWeight++;
+                batchCount += this->histogram[upperWeight];
+            };
+            return upperWeight;
+        };
+        size_t firstAbove = upper_bound(this->sample.begin(), this->sample.end(), this->lowerWeight) - this->sample.begin();
+        size_t position = firstAbove + (this->batchTarget * this->sample.size() + this->numEdges - 1) / this->numEdges;
+        if (position >= this->sample.size())
+        {
+            return UINT32_MAX;
+        };
+        return max(this->sample[position], this->lowerWeight + 1);
+    };
+
+    // Replaces `keys` with the next batch of edges, sorted. Returns false once every edge has been handed out.
+    bool nextBatch(vector<uint64_t> &keys)
+    {
+        scopedTimer timer("sort batch");
+        keys.clear();
+        while (keys.empty() && !this->exhausted)
+        {
+            uint32_t lowerWeight = this->lowerWeight;
+            uint32_t upperWeight = chooseUpperWeight();
+
+            // Inside nodes never take another connection.
+            graph *myGraph = this->myGraph;
+            int numNodes = myGraph->numNodes;
+            vector<char> insideNodes(numNodes);
+            for (int i = 0; i < numNodes; i++)
+            {
+                insideNodes[i] = (myGraph->nodes[i]->nodeType == 2);
+            };
+
+            // Collect the batch in matrix order, one block of rows of about equal size per chunk, then stitch the chunks together in order.
+            size_t numWeights = graph::triangleSize(numNodes);
+            size_t numChunks = max((size_t)1, min((size_t)globalThreadCount * 4, numWeights));
+            vector<int> chunkRows(numChunks + 1, numNodes);
+            for (size_t c = 0; c < numChunks; c++)
+            {
+                int row;
+                int column;
+                graph::edgeNodes(numWeights * c / numChunks, row, column);
+                chunkRows[c] = (c == 0) ? 1 : row;
+            };
+            vector<vector<uint64_t>> chunkKeys(numChunks);
+            parallelFor(numChunks, [&](size_t firstChunk, size_t lastChunk)
+                        {
+                for (size_t c = firstChunk; c < lastChunk; c++)
+                {
+                    for (int row = chunkRows[c]; row < chunkRows[c + 1]; row++)
+                    {
+                        if (insideNodes[row])
+                        {
+                            continue;
+                        };
+                        size_t rowStart = graph::triangleIndex(row, 0);
+                        for (int column = 0; column < row; column++)
+                        {
+                            uint32_t value = myGraph->weightAt(rowStart + column);
+                            if ((value > lowerWeight) && (value <= upperWeight) && !insideNodes[column])
+                            {
+                                chunkKeys[c].push_back(graph::edgeKey(value, rowStart + column));
+                            };
+                        };
+                    };
+                }; });
+            for (size_t c = 0; c < numChunks; c++)
+            {
+                keys.insert(keys.end(), chunkKeys[c].begin(), chunkKeys[c].end());
+            };
+
+            graph::sortWeghts(keys);
+            this->edgesHandedOut += keys.size();
+            this->lowerWeight = upperWeight;
+            this->exhausted = (upperWeight >= this->maxWeight);
+            this->batchTarget *= 4;
+        };
+        return !keys.empty();
+    };
+};
+
+// Applies the rules of the original algorithm to the edge between two nodes: connects them if the rules allow it, updating their node types and groups. Returns true if the connection was made.
+bool greedyConnect(graph *myGraph, disjointSet &nodeGroups, int currentLeftNodeNumber, int currentRightNodeNumber)
+{
+    node *currentLeftNode = myGraph->nodes.at(currentLeftNodeNumber);
+    node *currentRightNode = myGraph->nodes.at(currentRightNodeNumber);
+
+    if ((currentLeftNode->nodeType == 0) && (currentRightNode->nodeType == 0))
+    {
+        // Both nodes are untouched.
+        // We will use this weight to connect those nodes. The nodes each become leader nodes. They are added to a group together.
+        myGraph->connect(currentLeftNodeNumber, currentRightNodeNumber);
+        currentLeftNode->nodeType = 1;
+        currentRightNode->nodeType = 1;
+        nodeGroups.unite(currentLeftNodeNumber, currentRightNodeNumber);
+        return true;
+    }
+    else if ((currentLeftNode->nodeType == 2) && (currentRightNode->nodeType == 2))
+    {
+        // Both are inside nodes.
+        // We don't want to do anything.
+        return false;
+    }
+    else if ((currentLeftNode->nodeType == 1) && (currentRightNode->nodeType == 1))
+    {
+        // Both are leader nodes.
+        // We first need to check if they are in the same group.
+        if (nodeGroups.find(currentLeftNodeNumber) != nodeGroups.find(currentRightNodeNumber))
+        {
+            // If they are not in the same group, connect the two nodes with the weight, set them as inside nodes, and merge the two groups.
+            myGraph->connect(currentLeftNodeNumber, currentRightNodeNumber);
+            currentLeftNode->nodeType = 2;
+            currentRightNode->nodeType = 2;
+            nodeGroups.unite(currentLeftNodeNumber, currentRightNodeNumber);
+            return true;
+        };
+        return false;
+    }
+    else if (((currentLeftNode->nodeType == 1) && (currentRightNode->nodeType == 2)) || ((currentLeftNode->nodeType == 2) && (currentRightNode->nodeType == 1)))
+    {
+        // One node is a leader and one is an inside node.
+        // We don't want to do anything.
+        return false;
+    }
+    else if (((currentLeftNode->nodeType == 2) && (currentRightNode->nodeType == 0)) || ((currentLeftNode->nodeType == 0) && (currentRightNode->nodeType == 2)))
+    {
+        // One node is an inside node and one is untouched.
+        // We don't want to do anything.
+        return false;
+    }
+    else
+    {
+        // One is a leader and one is untouched.
+        // We connect them. The leader becomes an inside node. The untouched node becomes a leader. The untouched node joins the leader's group.
+        myGraph->connect(currentLeftNodeNumber, currentRightNodeNumber);
+        if (currentLeftNode->nodeType == 1)
+        {
+            // The left node was the leader.
+            currentLeftNode->nodeType = 2;
+            currentRightNode->nodeType = 1;
+        }
+        else
+        {
+            // The right node was the leader.
+            currentRightNode->nodeType = 2;
+            currentLeftNode->nodeType = 1;
+        };
+        nodeGroups.unite(currentLeftNodeNumber, currentRightNodeNumber);
+        return true;
+    };
+};
+
+// The result of parsing one row of a text graph file.
+enum parseResult
+{
+    parsedRow,
+    malformedRow,
+    rowOverflow // A value does not fit the element type; the caller retries with a wider matrix.
+};
+
+// Parses the `count` off-diagonal values of a row, followed by its diagonal 0, from the text [begin, end) into `out`. A row whose diagonal is not 0 is malformed. Weights above INT_MAX are rejected, since distances are added up as ints.
+template <typename weightType>
+parseResult parseRow(const char *begin, const char *end, weightType *out, size_t count)
+{
+    size_t parsed = 0;
+    const char *cursor = begin;
+    while (true)
+    {
+        while ((cursor < end) && ((*cursor == ' ') || (*cursor == '\t') || (*cursor == '\r') || (*cursor == '\n')))
+        {
+            cursor++;
+        };
+        if (cursor == end)
+        {
+            break;
+        };
+        if ((*cursor < '0') || (*cursor > '9') || (parsed > count))
+        {
+            return malformedRow;
+        };
+        uint64_t value = 0;
+        while ((cursor < end) && (*cursor >= '0') && (*cursor <= '9'))
+        {
+            value = value * 10 + (*cursor - '0');
+            if (value > INT_MAX)
+            {
+                return malformedRow;
+            };
+            cursor++;
+        };
+        if (parsed < count)
+        {
+            if (value > numeric_limits<weightType>::max())
+            {
+                return rowOverflow;
+            };
+            out[parsed] = value;
+        }
+        else if (value != 0)
+        {
+            return malformedRow;
+        };
+        parsed++;
+    };
+    return (parsed == count + 1) ? parsedRow : malformedRow;
+};
+
+// The header at the start of a binary graph file. It is followed by the lower triangle without the diagonal (row 1, then row 2, ...), packed as weightWidth-byte unsigned integers.
+// This is the same layout as the graph's matrix, so binary files are used in place.
+struct binaryGraphHeader
+{
+    char magic[4];        // Always "TSPB".
+    uint32_t version;     // The format version, currently binaryGraphVersion.
+    uint32_t numNodes;    // The number of nodes (rows) in the graph.
+    uint32_t weightWidth; // The bytes per weight: 2 (uint16) or 4 (uint32).
+};
+const char binaryGraphMagic[4] = {'T', 'S', 'P', 'B'};
+const uint32_t binaryGraphVersion = 1;
+
+// Returns the default name of the binary copy of a graph file: the same name with the extension replaced by .bgraph.
+string binaryGraphName(const string &fileName)
+{
+    size_t dot = fileName.find_last_of('.');
+    size_t slash = fileName.find_last_of('/');
+    if ((dot == string::npos) || ((slash != string::npos) && (dot < slash)))
+    {
+        return fileName + ".bgraph";
+    };
+    return fileName.substr(0, dot) + ".bgraph";
+};
+
+// Points myGraph's matrix straight into a mapped binary graph file. Nothing is parsed or copied.
+bool loadBinaryGraph(unique_ptr<mappedFile> &file, graph *myGraph)
+{
+    binaryGraphHeader header;
+    memcpy(&header, file->data, sizeof(header));
+    if (header.version != binaryGraphVersion)
+    {
+        cerr << "Unsupported binary graph version " << header.version << " (expected " << binaryGraphVersion << ")." << endl;
+        return false;
+    };
+    if ((header.weightWidth != 2) && (header.weightWidth != 4))
+    {
+        cerr << "Unsupported binary graph weight width " << header.weightWidth << "." << endl;
+        return false;
+    };
+    if ((header.numNodes == 0) || (file->size != sizeof(header) + graph::triangleSize(header.numNodes) * header.weightWidth))
+    {
+        cerr << "Binary graph file is truncated or corrupt." << endl;
+        return false;
+    };
+
+    myGraph->numNodes = header.numNodes;
+    myGraph->weightWidth = header.weightWidth;
+    const char *packed = file->data + sizeof(header);
+    if (header.weightWidth == 2)
+    {
+        myGraph->matrix16 = (const uint16_t *)packed;
+    }
+    else
+    {
+        myGraph->matrix32 = (const uint32_t *)packed;
+    };
+    myGraph->mapping = move(file);
+    myGraph->createNodes();
+    return true;
+};
+
+// Writes myGraph to a binary graph file, keeping the weight width of its matrix.
+bool writeBinaryGraph(graph *myGraph, const string &fileName)
+{
+    binaryGraphHeader header;
+    memcpy(header.magic, binaryGraphMagic, sizeof(header.magic));
+    header.version = binaryGraphVersion;
+    header.numNodes = myGraph->numNodes;
+    header.weightWidth = myGraph->weightWidth;
+
+    ofstream outFile(fileName, ios::binary);
+    if (!outFile.is_open())
+    {
+        return false;
+    };
+    outFile.write((const char *)&header, sizeof(header));
+    const char *packed = (myGraph->weightWidth == 2) ? (const char *)myGraph->matrix16 : (const char *)myGraph->matrix32;
+    outFile.write(packed, graph::triangleSize(myGraph->numNodes) * myGraph->weightWidth);
+    outFile.close();
+    return !outFile.fail();
+};
+
+// Parses the rows of a mapped text graph file into a matrix of the given element type, one block of rows per task. Returns the first bad row and its result, or parsedRow.
+template <typename weightType>
+parseResult parseRows(const mappedFile &file, const vector<size_t> &rowStarts, const vector<int> &blockStarts, weightType *matrix, int &badRow)
+{
+    int numBlocks = blockStarts.size() - 1;
+    vector<parseResult> blockResults(numBlocks, parsedRow);
+    vector<int> badRows(numBlocks, -1);
+    parallelFor(numBlocks, [&](size_t firstBlock, size_t lastBlock)
+                {
+        for (size_t b = firstBlock; b < lastBlock; b++)
+        {
+            scopedTimer timer("parse block");
+            for (int row = blockStarts.at(b); row < blockStarts.at(b + 1); row++)
+            {
+                parseResult result = parseRow(file.data + rowStarts[row], file.data + rowStarts[row + 1], matrix + graph::triangleIndex(row, 0), row);
+                if (result != parsedRow)
+                {
+                    blockResults.at(b) = result;
+                    badRows.at(b) = row;
+                    break;
+                };
+            };
+
+            // Row i holds i + 1 numbers.
+            uint64_t firstRow = blockStarts.at(b);
+            uint64_t lastRow = blockStarts.at(b + 1);
+            countStat(tokensParsed, (lastRow * (lastRow + 1) - firstRow * (firstRow + 1)) / 2);
+        }; });
+    for (int b = 0; b < numBlocks; b++)
+    {
+        if (blockResults.at(b) != parsedRow)
+        {
+            badRow = badRows.at(b);
+            return blockResults.at(b);
+        };
+    };
+    return parsedRow;
+};
+
+// Returns the number of whitespace-separated values in the text [begin, end).
+int countValues(const char *begin, const char *end)
+{
+    int count = 0;
+    bool inValue = false;
+    for (const char *cursor = begin; cursor < end; cursor++)
+    {
+        bool space = (*cursor == ' ') || (*cursor == '\t') || (*cursor == '\r') || (*cursor == '\n');
+        count += (!space && !inValue);
+        inValue = !space;
+    };
+    return count;
+};
+
+// Parses the "x y" of one row of a coordinate file from the text [begin, end). Returns false unless the row holds exactly two finite numbers.
+bool parsePoint(const char *begin, const char *end, double &x, double &y)
+{
+    double values[2];
+    int parsed = 0;
+    const char *cursor = begin;
+    while (true)
+    {
+        while ((cursor < end) && ((*cursor == ' ') || (*cursor == '\t') || (*cursor == '\r') || (*cursor == '\n')))
+        {
+            cursor++;
+        };
+        if (cursor == end)
+        {
+            break;
+        };
+        const char *valueEnd = cursor;
+        while ((valueEnd < end) && (*valueEnd != ' ') && (*valueEnd != '\t') && (*valueEnd != '\r') && (*valueEnd != '\n'))
+        {
+            valueEnd++;
+        };
+
+        // The mapped file is not null-terminated, so each number is copied out before strtod reads it.
+        char buffer[64];
+        if ((parsed == 2) || (valueEnd - cursor >= (ptrdiff_t)sizeof(buffer)))
+        {
+            return false;
+        };
+        memcpy(buffer, cursor, valueEnd - cursor);
+        buffer[valueEnd - cursor] = '\0';
+        char *numberEnd;
+        values[parsed] = strtod(buffer, &numberEnd);
+        if ((*numberEnd != '\0') || !isfinite(values[parsed]))
+        {
+            return false;
+        };
+        parsed++;
+        cursor = valueEnd;
+    };
+    x = values[0];
+    y = values[1];
+    return parsed == 2;
+};
+
+// Reads the points of a coordinate file (one "x y" row per node) into myGraph, one block of rows per task. No matrix is built, so a graph of a million points takes 16 MB.
+bool loadCoordinates(const mappedFile &file, const vector<size_t> &rowStarts, const vector<int> &blockStarts, graph *myGraph)
+{
+    int numRows = rowStarts.size() - 1;
+    int numBlocks = blockStarts.size() - 1;
+    myGraph->numNodes = numRows;
+    myGraph->coordinates = true;
+    myGraph->xCoords.resize(numRows);
+    myGraph->yCoords.resize(numRows);
+    vector<int> badRows(numBlocks, -1);
+    parallelFor(numBlocks, [&](size_t firstBlock, size_t lastBlock)
+                {
+        for (size_t b = firstBlock; b < lastBlock; b++)
+        {
+            scopedTimer timer("parse block");
+            countStat(tokensParsed, 2 * (blockStarts.at(b + 1) - blockStarts.at(b)));
+            for (int row = blockStarts.at(b); row < blockStarts.at(b + 1); row++)
+            {
+                if (!parsePoint(file.data + rowStarts[row], file.data + rowStarts[row + 1], myGraph->xCoords[row], myGraph->yCoords[row]))
+                {
+                    badRows.at(b) = row;
+                    break;
+                };
+            };
+        }; });
+    for (int b = 0; b < numBlocks; b++)
+    {
+        if (badRows.at(b) != -1)
+        {
+            cerr << "Malformed coordinate file: row " << badRows.at(b) << " should hold exactly two numbers (x y)." << endl;
+            return false;
+        };
+    };
+
+    // Distances are added up as ints, so no two points may be further apart than INT_MAX.
+    double width = *max_element(myGraph->xCoords.begin(), myGraph->xCoords.end()) - *min_element(myGraph->xCoords.begin(), myGraph->xCoords.end());
+    double height = *max_element(myGraph->yCoords.begin(), myGraph->yCoords.end()) - *min_element(myGraph->yCoords.begin(), myGraph->yCoords.end());
+    if (sqrt(width * width + height * height) >= INT_MAX)
+    {
+        cerr << "The points of the coordinate file are too far apart: every distance must be below " << INT_MAX << "." << endl;
+        return false;
+    };
+    myGraph->createNodes();
+    return true;
+};
+
+// Reads a graph file into myGraph. Binary graph files (see convert mode) are recognised by their header and used in place without parsing.
+// Text files are lower-triangular, or coordinate files of one "x y" point per row, which are told apart by their first row (a lower-triangular file starts with a lone 0). The file is memory-mapped and the newline offsets are indexed first, so that blocks of rows can be parsed in parallel straight into the matrix (or the points).
+// The matrix is parsed as uint16 first and only re-parsed as uint32 if a weight does not fit.
+bool loadGraph(const char *fileName, graph *myGraph)
+{
+    scopedTimer timer("load graph");
+    unique_ptr<mappedFile> file(new mappedFile());
+    if (!file->open(fileName))
+    {
+        cerr << "File cannot be opened." << endl;
+        return false;
+    };
+    if ((file->size >= sizeof(binaryGraphHeader)) && (memcmp(file->data, binaryGraphMagic, sizeof(binaryGraphMagic)) == 0))
+    {
+        return loadBinaryGraph(file, myGraph);
+    };
+    file->adviseSequential();
+
+    // Index where every row starts. Row i spans [rowStarts[i], rowStarts[i + 1]). Trailing blank lines are ignored.
+    vector<size_t> rowStarts;
+    const char *cursor = file->data;
+    const char *fileEnd = file->data + file->size;
+    while (cursor < fileEnd)
+    {
+        rowStarts.push_back(cursor - file->data);
+        const char *newline = (const char *)memchr(cursor, '\n', fileEnd - cursor);
+        cursor = (newline == nullptr) ? fileEnd : newline + 1;
+    };
+    rowStarts.push_back(file->size);
+    while ((rowStarts.size() > 1) && (strspn(file->data + rowStarts.at(rowStarts.size() - 2), " \t\r\n") >= rowStarts.back() - rowStarts.at(rowStarts.size() - 2)))
+    {
+        rowStarts.pop_back();
+        rowStarts.back() = file->size;
+    };
+    int numRows = rowStarts.size() - 1;
+    if (numRows == 0)
+    {
+        cerr << "The graph file is empty." << endl;
+        return false;
+    };
+
+    // Split the rows into blocks of roughly equal byte size (later rows are longer), so that the blocks can be parsed in parallel.
+    int numBlocks = min(numRows, globalThreadCount * 4);
+    vector<int> blockStarts(numBlocks + 1, numRows);
+    for (int b = 0; b < numBlocks; b++)
+    {
+        size_t targetByte = file->size * b / numBlocks;
+        blockStarts.at(b) = upper_bound(rowStarts.begin(), rowStarts.end() - 1, targetByte) - rowStarts.begin() - 1;
+    };
+
+    if (countValues(file->data + rowStarts.at(0), file->data + rowStarts.at(1)) == 2)
+    {
+        return loadCoordinates(*file, rowStarts, blockStarts, myGraph);
+    };
+
+    // Row i always holds i values before its diagonal, so every row knows where it goes in the matrix before anything is parsed.
+    int badRow = -1;
+    myGraph->allocateMatrix(numRows, 2);
+    parseResult result = parseRows(*file, rowStarts, blockStarts, myGraph->storage16.data(), badRow);
+    if (result == rowOverflow)
+    {
+        myGraph->allocateMatrix(numRows, 4);
+        result = parseRows(*file, rowStarts, blockStarts, myGraph->storage32.data(), badRow);
+    };
+    if (result != parsedRow)
+    {
+        cerr << "Malformed graph file: row " << badRow << " should hold exactly " << badRow + 1 << " non-negative integers, ending with 0." << endl;
+        return false;
+    };
+
+    myGraph->createNodes();
+    return true;
+};
+
+// The next value of a splitmix64 generator. It is tiny and fast, and seeding one generator per row keeps the generated graphs identical however the rows are shared out over threads.
+inline uint64_t splitMix(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+};
+
+// Returns the starting state of the generator for one row (or point) of a generated graph.
+inline uint64_t rowState(uint64_t seed, uint64_t row)
+{
+    uint64_t state = seed ^ ((row + 1) * 0xD1B54A32D192ED03ULL);
+    splitMix(state);
+    return state;
+};
+
+// Returns a uniformly distributed double in [0, 1).
+inline double unitRandom(uint64_t &state)
+{
+    return (splitMix(state) >> 11) * (1.0 / 9007199254740992.0);
+};
+
+// Draws the `row` weights (1 to 1000) of one row of a uniform graph.
+template <typename weightType>
+inline void uniformRow(uint64_t seed, size_t row, weightType *weights)
+{
+    uint64_t state = rowState(seed, row);
+    for (size_t column = 0; column < row; column++)
+    {
+        weights[column] = 1 + splitMix(state) % 1000;
+    };
+};
+
+// The side of the square that generated points lie in.
+const double generatedSide = 1000000;
+
+// Fills myGraph with a random graph of the given family, the same for the same family, size and seed:
+//     uniform:   a full matrix of weights from 1 to 1000, like graphMaker.py.
+//     euclidean: points with integer coordinates spread uniformly over a square of side generatedSide.
+//     clustered: the same square, with the points gathered in normally distributed clusters around numNodes / 100 (at least one) uniformly placed centers.
+// The point families are coordinate graphs, so they need no matrix. Every row (or point) is drawn from its own generator, in parallel. Returns false if the family is unknown.
+bool generateGraph(const string &family, int numNodes, uint64_t seed, graph *myGraph)
+{
+    scopedTimer timer("generate graph");
+    if (family == "uniform")
+    {
+        myGraph->allocateMatrix(numNodes, 2);
+        parallelFor(numNodes, [&](size_t firstRow, size_t lastRow)
+                    {
+            for (size_t row = firstRow; row < lastRow; row++)
+            {
+                uniformRow(seed, row, &myGraph->storage16[graph::triangleIndex(row, 0)]);
+            }; });
+    }
+    else if ((family == "euclidean") || (family == "clustered"))
+    {
+        // The cluster centers are drawn first, from the generator of the seed itself.
+        int numCenters = max(1, numNodes / 100);
+        double spread = generatedSide / (4 * sqrt((double)numCenters));
+        vector<double> centerX(numCenters);
+        vector<double> centerY(numCenters);
+        uint64_t centerState = seed;
+        for (int c = 0; c < numCenters; c++)
+        {
+            centerX[c] = unitRandom(centerState) * generatedSide;
+            centerY[c] = unitRandom(centerState) * generatedSide;
+        };
+        bool clustered = (family == "clustered");
+        myGraph->numNodes = numNodes;
+        myGraph->coordinates = true;
+        myGraph->xCoords.resize(numNodes);
+        myGraph->yCoords.resize(numNodes);
+        parallelFor(numNodes, [&](size_t firstPoint, size_t lastPoint)
+                    {
+            for (size_t i = firstPoint; i < lastPoint; i++)
+            {
+                uint64_t state = rowState(seed, i);
+                double x = unitRandom(state) * generatedSide;
+                double y = unitRandom(state) * generatedSide;
+                if (clustered)
+                {
+                    // Box-Muller: two uniform values give two normally distributed offsets from a random center.
+                    int c = splitMix(state) % numCenters;
+                    double radius = spread * sqrt(-2 * log(1 - unitRandom(state)));
+                    double angle = 2 * M_PI * unitRandom(state);
+                    x = min(generatedSide - 1, max(0.0, centerX[c] + radius * cos(angle)));
+                    y = min(generatedSide - 1, max(0.0, centerY[c] + radius * sin(angle)));
+                };
+                myGraph->xCoords[i] = floor(x);
+                myGraph->yCoords[i] = floor(y);
+            }; });
+    }
+    else
+    {
+        return false;
+    };
+    myGraph->createNodes();
+    return true;
+};
+
+// Reads a text graph file front to back in chunks of whole rows, so that graphs far larger than memory can be scanned. Only one chunk of text and its parsed values are held at a time.
+class graphStream
+{
+public:
+    string fileName;
+    int numNodes;
+    size_t chunkBytes;
+
+    // Default constructor
+    graphStream()
+    {
+        this->numNodes = 0;
+        this->chunkBytes = 0;
+    };
+
+    // Finds the number of nodes from the last row, which holds one value per node, without reading the rest of the file. Returns false (with a message) if the file cannot be read, is empty or is binary.
+    bool open(const string &fileName, size_t chunkBytes)
+    {
+        this->fileName = fileName;
+        this->chunkBytes = chunkBytes;
+        ifstream in(fileName, ios::binary | ios::ate);
+        if (!in.is_open())
+        {
+            cerr << "File cannot be opened." << endl;
+            return false;
+        };
+        size_t fileSize = in.tellg();
+        this->chunkBytes = min(this->chunkBytes, fileSize + 1);
+        char magic[sizeof(binaryGraphMagic)] = {};
+        in.seekg(0);
+        in.read(magic, sizeof(magic));
+        if ((fileSize >= sizeof(binaryGraphHeader)) && (memcmp(magic, binaryGraphMagic, sizeof(binaryGraphMagic)) == 0))
+        {
+            cerr << "Stream mode reads text graph files only." << endl;
+            return false;
+        };
+
+        // Read a growing tail of the file until it holds the whole last non-blank row.
+        string tail;
+        for (size_t tailBytes = 4096;; tailBytes *= 2)
+        {
+            tailBytes = min(tailBytes, fileSize);
+            tail.resize(tailBytes);
+            in.clear();
+            in.seekg(fileSize - tailBytes);
+            in.read(&tail[0], tailBytes);
+            size_t rowEnd = tail.find_last_not_of(" \t\r\n");
+            size_t rowStart = (rowEnd == string::npos) ? string::npos : tail.find_last_of('\n', rowEnd);
+            if ((rowStart != string::npos) || (tailBytes == fileSize))
+            {
+                if (rowEnd == string::npos)
+                {
+                    cerr << "The graph file is empty." << endl;
+                    return false;
+                };
+                istringstream lastRow(tail.substr((rowStart == string::npos) ? 0 : rowStart + 1, rowEnd + 1));
+                string value;
+                while (lastRow >> value)
+                {
+                    this->numNodes++;
+                };
+                return true;
+            };
+        };
+    };
+
+    // Reads every row once, in order. Rows with wanted[row] set to 0 are skipped without being parsed. The others are parsed in parallel, one chunk at a time, and handed to visit as (row, values), where values holds the row's `row` off-diagonal weights. Returns false (with a message) if the file cannot be read or a wanted row is malformed.
+    bool forEachRow(const vector<char> &wanted, const function<void(int, const uint32_t *)> &visit) const
+    {
+        scopedTimer timer("read pass");
+        ifstream in(this->fileName, ios::binary);
+        if (!in.is_open())
+        {
+            cerr << "File cannot be opened." << endl;
+            return false;
+        };
+        vector<char> buffer(this->chunkBytes);
+        vector<const char *> lineStarts;
+        vector<size_t> valueOffsets;
+        vector<uint32_t> values;
+        size_t carried = 0;
+        int row = 0;
+        bool atEnd = false;
+        while (!atEnd)
+        {
+            // Top the buffer up behind the part of a row carried over from the last chunk. A row longer than the buffer doubles it.
+            if (carried == buffer.size())
+            {
+                buffer.resize(2 * buffer.size());
+            };
+            in.read(buffer.data() + carried, buffer.size() - carried);
+            size_t filled = carried + in.gcount();
+            atEnd = (in.gcount() == 0) || in.eof();
+            const char *chunkEnd = buffer.data() + filled;
+            if (!atEnd)
+            {
+                const char *lastNewline = (const char *)memrchr(buffer.data(), '\n', filled);
+                if (lastNewline == nullptr)
+                {
+                    carried = filled;
+                    continue;
+                };
+                chunkEnd = lastNewline + 1;
+            };
+
+            // Split the chunk into rows. Blank lines after the last row are ignored.
+            lineStarts.clear();
+            valueOffsets.assign(1, 0);
+            int firstRow = row;
+            for (const char *cursor = buffer.data(); cursor < chunkEnd; row++)
+            {
+                const char *newline = (const char *)memchr(cursor, '\n', chunkEnd - cursor);
+                const char *lineEnd = (newline == nullptr) ? chunkEnd : newline + 1;
+                if (row >= this->numNodes)
+                {
+                    if (strspn(cursor, " \t\r\n") < (size_t)(lineEnd - cursor))
+                    {
+                        cerr << "Malformed graph file: it has more than " << this->numNodes << " rows." << endl;
+                        return false;
+                    };
+                }
+                else
+                {
+                    lineStarts.push_back(cursor);
+                    valueOffsets.push_back(valueOffsets.back() + (wanted[row] ? row : 0));
+                };
+                cursor = lineEnd;
+            };
+            lineStarts.push_back(chunkEnd);
+
+            // Parse the wanted rows in parallel, then hand them over in order.
+            int numRows = lineStarts.size() - 1;
+            values.resize(valueOffsets.back());
+            atomic<int> badRow(-1);
+            parallelFor(numRows, [&](size_t begin, size_t end)
+                        {
+                for (size_t r = begin; r < end; r++)
+                {
+                    int rowNumber = firstRow + r;
+                    if (wanted[rowNumber] && (parseRow<uint32_t>(lineStarts[r], lineStarts[r + 1], values.data() + valueOffsets[r], rowNumber) != parsedRow))
+                    {
+                        int expected = -1;
+                        badRow.compare_exchange_strong(expected, rowNumber);
+                    };
+                }; });
+            if (badRow != -1)
+            {
+                cerr << "Malformed graph file: row " << badRow << " should hold exactly " << badRow + 1 << " non-negative integers, ending with 0." << endl;
+                return false;
+            };
+            countStat(tokensParsed, values.size());
+            for (int r = 0; r < numRows; r++)
+            {
+                if (wanted[firstRow + r])
+                {
+                    visit(firstRow + r, values.data() + valueOffsets[r]);
+                };
+            };
+
+            carried = buffer.data() + filled - chunkEnd;
+            memmove(buffer.data(), chunkEnd, carried);
+        };
+        if (row < this->numNodes)
+        {
+            cerr << "Malformed graph file: it ends after " << row << " of " << this->numNodes << " rows." << endl;
+            return false;
+        };
+        return true;
+    };
+};
+
+// One edge kept by stream mode, ordered like the original algorithm's sorted edges: by weight, then row, then column.
+struct streamEdge
+{
+    uint32_t weight;
+    int row; // The larger node.
+    int col; // The smaller node.
+
+    bool operator<(const streamEdge &other) const
+    {
+        return (this->weight != other.weight) ? (this->weight < other.weight) : (this->row != other.row) ? (this->row < other.row) : (this->col < other.col);
+    };
+    bool operator==(const streamEdge &other) const
+    {
+        return (this->weight == other.weight) && (this->row == other.row) && (this->col == other.col);
+    };
+};
+
+// Offers an edge to a node's bounded max-heap of its k cheapest edges. Keys are weight << 32 | other node, so ties go to the lower node, as in the original algorithm's order.
+inline void offerEdge(uint64_t *heap, int &heapSize, int k, uint64_t key)
+{
+    if (heapSize < k)
+    {
+        heap[heapSize] = key;
+        heapSize++;
+        push_heap(heap, heap + heapSize);
+    }
+    else if (key < heap[0])
+    {
+        pop_heap(heap, heap + k);
+        heap[k - 1] = key;
+        push_heap(heap, heap + k);
+    };
+};
+
+// A uniform grid over the points of a coordinate graph, so that the points nearest to a node are found without looking at every other point.
+// The cells are squares sized to hold about two points each. The points of a cell are one contiguous run of cellPoints, and removing a point swaps it to the end of its cell's run and shortens the run, so later queries only see the points that are left.
+// Queries rank points the way the matrix modes do, by rounded distance and then by node number. They search rings of cells outward from the node and stop once every cell further out is too far away to hold anything better.
+class pointGrid
+{
+public:
+    const graph *myGraph;
+    double minX;
+    double minY;
+    double cellSize;
+    int columns;
+    int rows;
+
+    // The points of cell c are cellPoints[cellStart[c]] onwards, and the first cellCount[c] of them are still in the grid.
+    vector<int> cellStart;
+    vector<int> cellCount;
+    vector<int> cellPoints;
+
+    // Where every point is in cellPoints.
+    vector<int> slot;
+
+    // How many distances nearest has compared (for --stats).
+    uint64_t evaluations;
+
+    // Default constructor
+    pointGrid()
+    {
+        this->myGraph = nullptr;
+        this->minX = 0;
+        this->minY = 0;
+        this->cellSize = 1;
+        this->columns = 0;
+        this->rows = 0;
+        this->evaluations = 0;
+    };
+
+    // Returns the column and the row of the cell that holds a position.
+    inline int columnOf(double x) const
+    {
+        return min(this->columns - 1, max(0, (int)((x - this->minX) / this->cellSize)));
+    };
+    inline int rowOf(double y) const
+    {
+        return min(this->rows - 1, max(0, (int)((y - this->minY) / this->cellSize)));
+    };
+    inline int cellOf(int point) const
+    {
+        return rowOf(this->myGraph->yCoords[point]) * this->columns + columnOf(this->myGraph->xCoords[point]);
+    };
+
+    // Puts every node of a coordinate graph into the grid, or only the nodes whose allowed flag is set.
+    void build(const graph *myGraph, const vector<char> *allowed = nullptr)
+    {
+        this->myGraph = myGraph;
+        vector<int> members;
+        members.reserve(myGraph->numNodes);
+        double maxX = -numeric_limits<double>::infinity();
+        double maxY = -numeric_limits<double>::infinity();
+        this->minX = numeric_limits<double>::infinity();
+        this->minY = numeric_limits<double>::infinity();
+        for (int i = 0; i < myGraph->numNodes; i++)
+        {
+            if ((allowed == nullptr) || (*allowed)[i])
+            {
+                members.push_back(i);
+                this->minX = min(this->minX, myGraph->xCoords[i]);
+                this->minY = min(this->minY, myGraph->yCoords[i]);
+                maxX = max(maxX, myGraph->xCoords[i]);
+                maxY = max(maxY, myGraph->yCoords[i]);
+            };
+        };
+        if (members.empty())
+        {
+            this->minX = 0;
+            this->minY = 0;
+            maxX = 0;
+            maxY = 0;
+        };
+
+        // Size the cells by the area the points cover, but never so small that a thin strip of points gets more columns (or rows) than there are cells.
+        double width = maxX - this->minX;
+        double height = maxY - this->minY;
+        double targetCells = max((size_t)1, members.size() / 2);
+        this->cellSize = max(sqrt(width * height / targetCells), max(width, height) / targetCells);
+        if (this->cellSize <= 0)
+        {
+            this->cellSize = 1;
+        };
+        this->columns = (int)min(targetCells, width / this->cellSize) + 1;
+        this->rows = (int)min(targetCells, height / this->cellSize) + 1;
+
+        // Sort the points into their cells with one counting pass.
+        size_t numCells = (size_t)this->columns * this->rows;
+        this->cellStart.assign(numCells + 1, 0);
+        this->cellCount.assign(numCells, 0);
+        for (size_t i = 0; i < members.size(); i++)
+        {
+            this->cellCount[cellOf(members[i])]++;
+        };
+        for (size_t c = 0; c < numCells; c++)
+        {
+            this->cellStart[c + 1] = this->cellStart[c] + this->cellCount[c];
+        };
+        this->cellPoints.resize(members.size());
+        this->slot.assign(myGraph->numNodes, -1);
+        vector<int> filled(this->cellStart.begin(), this->cellStart.end() - 1);
+        for (size_t i = 0; i < members.size(); i++)
+        {
+            int position = filled[cellOf(members[i])]++;
+            this->cellPoints[position] = members[i];
+            this->slot[members[i]] = position;
+        };
+    };
+
+    // Takes a point out of the grid. It must still be in it.
+    void remove(int point)
+    {
+        int cell = cellOf(point);
+        int last = this->cellStart[cell] + this->cellCount[cell] - 1;
+        int lastPoint = this->cellPoints[last];
+        this->cellPoints[this->slot[point]] = lastPoint;
+        this->slot[lastPoint] = this->slot[point];
+        this->cellPoints[last] = point;
+        this->slot[point] = last;
+        this->cellCount[cell]--;
+    };
+
+    // Returns how far a position in cell (column, row) is from every cell more than `ring` cells away, or infinity if there are no such cells.
+    double ringGap(double x, double y, int column, int row, int ring) const
+    {
+        const double far = numeric_limits<double>::infinity();
+        double left = (column - ring > 0) ? x - (this->minX + (column - ring) * this->cellSize) : far;
+        double right = (column + ring < this->columns - 1) ? (this->minX + (column + ring + 1) * this->cellSize) - x : far;
+        double below = (row - ring > 0) ? y - (this->minY + (row - ring) * this->cellSize) : far;
+        double above = (row + ring < this->rows - 1) ? (this->minY + (row + ring + 1) * this->cellSize) - y : far;
+        return min(min(left, right), min(below, above));
+    };
+
+    // Calls visit(point) for every point left in the cells exactly `ring` cells away from cell (column, row).
+    template <typename visitor>
+    void visitRing(int column, int row, int ring, visitor visit) const
+    {
+        int firstColumn = max(0, column - ring);
+        int lastColumn = min(this->columns - 1, column + ring);
+        for (int r = max(0, row - ring); r <= min(this->rows - 1, row + ring); r++)
+        {
+            // Inner rows of the ring only have its two side cells.
+            bool edgeRow = (r == row - ring) || (r == row + ring);
+            int step = (edgeRow || (ring == 0)) ? 1 : 2 * ring;
+            for (int c = edgeRow ? firstColumn : column - ring; c <= lastColumn; c += step)
+            {
+                if (c < 0)
+                {
+                    continue;
+                };
+                int cell = r * this->columns + c;
+                for (int i = this->cellStart[cell]; i < this->cellStart[cell] + this->cellCount[cell]; i++)
+                {
+                    visit(this->cellPoints[i]);
+                };
+            };
+        };
+    };
+
+    // Returns the point left in the grid that is nearest to node `from` (which is never returned itself), or -1 if there is none.
+    int nearest(int from)
+    {
+        double x = this->myGraph->xCoords[from];
+        double y = this->myGraph->yCoords[from];
+        int column = columnOf(x);
+        int row = rowOf(y);
+        int best = -1;
+        int bestWeight = INT_MAX;
+        for (int ring = 0;; ring++)
+        {
+            visitRing(column, row, ring, [&](int point)
+                      {
+                int weight = this->myGraph->pointDistance(from, point);
+                this->evaluations++;
+                if ((point != from) && ((weight < bestWeight) || ((weight == bestWeight) && (point < best))))
+                {
+                    best = point;
+                    bestWeight = weight;
+                }; });
+
+            // A point further out is at least the gap away, so it rounds to more than bestWeight once the gap is over bestWeight + 0.5.
+            double gap = ringGap(x, y, column, row, ring);
+            if (isinf(gap) || ((best != -1) && (gap > bestWeight + 0.5)))
+            {
+                return best;
+            };
+        };
+    };
+
+    // Finds the k points left in the grid that are nearest to node `from` (not counting from itself). They are kept in heap as a max-heap of (rounded distance << 32 | node) keys; returns how many were found.
+    int nearestK(int from, int k, uint64_t *heap) const
+    {
+        double x = this->myGraph->xCoords[from];
+        double y = this->myGraph->yCoords[from];
+        int column = columnOf(x);
+        int row = rowOf(y);
+        int heapSize = 0;
+        for (int ring = 0; k > 0; ring++)
+        {
+            visitRing(column, row, ring, [&](int point)
+                      {
+                if (point != from)
+                {
+                    offerEdge(heap, heapSize, k, ((uint64_t)this->myGraph->pointDistance(from, point) << 32) | (uint32_t)point);
+                }; });
+            double gap = ringGap(x, y, column, row, ring);
+            if (isinf(gap) || ((heapSize == k) && (gap > (double)(heap[0] >> 32) + 0.5)))
+            {
+                break;
+            };
+        };
+        return heapSize;
+    };
+};
+
+// Runs the original algorithm along the cheapest edges of every node only, and writes the path into path. Returns the total distance, or -1 on failure.
+// Each pass asks collectEdges for the k cheapest edges between allowed nodes (every node in the first pass), where it also reports k or -1 on failure, and the original rules join nodes along them in sorted order. The chains that are left are then joined by more passes in which only chain ends (leaders) and untouched nodes are allowed; every end gets at least two such edges, so one of them always leads to another chain and every pass makes progress. closingDistance gives the distance between the two ends of the last chain.
+long long greedyPasses(int numNodes, const function<int(const vector<char> &, int, vector<streamEdge> &)> &collectEdges, const function<long long(int, int)> &closingDistance, vector<int> &path)
+{
+    path.assign(1, 0);
+    if (numNodes == 1)
+    {
+        return 0;
+    };
+    graph chainGraph;
+    chainGraph.numNodes = numNodes;
+    chainGraph.createNodes();
+    chainGraph.connections.assign(2 * numNodes, -1);
+    disjointSet nodeGroups(numNodes);
+    vector<char> allowed(numNodes, 1);
+    int numAllowed = numNodes;
+    int numConnections = 0;
+    long long totalWeight = 0;
+    for (int pass = 1; numConnections < numNodes - 1; pass++)
+    {
+        scopedTimer timer("greedy pass");
+        vector<streamEdge> edges;
+        int k = collectEdges(allowed, numAllowed, edges);
+        if (k < 0)
+        {
+            return -1;
+        };
+
+        // Sort the kept edges (an edge kept by both of its nodes only once) and apply the original rules to them in order.
+        sort(edges.begin(), edges.end());
+        edges.erase(unique(edges.begin(), edges.end()), edges.end());
+        int connectionsBefore = numConnections;
+        size_t i = 0;
+        for (; (i < edges.size()) && (numConnections < numNodes - 1); i++)
+        {
+            if (greedyConnect(&chainGraph, nodeGroups, edges[i].row, edges[i].col))
+            {
+                numConnections++;
+                totalWeight += edges[i].weight;
+            };
+        };
+        countStat(edgesScanned, i);
+        countStat(edgesAccepted, numConnections - connectionsBefore);
+        progress() << "Pass " << pass << ": kept " << k << " edges for each of " << numAllowed << " nodes, made " << numConnections - connectionsBefore << " connections (" << numConnections << " of " << numNodes - 1 << ")" << '\n';
+        if (numConnections == connectionsBefore)
+        {
+            cerr << "No connection could be made in pass " << pass << endl;
+            return -1;
+        };
+
+        // Only chain ends (leaders) and untouched nodes can take another connection.
+        numAllowed = 0;
+        for (int v = 0; v < numNodes; v++)
+        {
+            allowed[v] = (chainGraph.nodes.at(v)->nodeType != 2);
+            numAllowed += allowed[v];
+        };
+    };
+
+    // Connect the two end nodes. These will be the only leader nodes left.
+    int nodeOne = -1;
+    int nodeTwo = -1;
+    for (int v = 0; v < numNodes; v++)
+    {
+        if (chainGraph.nodes.at(v)->nodeType == 1)
+        {
+            if (nodeOne == -1)
+            {
+                nodeOne = v;
+            };
+            nodeTwo = v;
+        };
+    };
+    nodeGroups.countStats();
+    long long closingWeight = closingDistance(nodeOne, nodeTwo);
+    if (closingWeight < 0)
+    {
+        return -1;
+    };
+    totalWeight += closingWeight;
+    chainGraph.connect(nodeOne, nodeTwo);
+    chainGraph.retracePath(nodeOne);
+    path.assign(chainGraph.pathTaken.begin(), chainGraph.pathTaken.end() - 1);
+    return totalWeight;
+};
+
+// Runs the original algorithm on a coordinate graph, along the nearest --candidates=K (16 by default) neighbors of every node, which the point grid finds without any matrix. This gives the same path as stream mode on the matching matrix.
+long long coordinateGreedy(const graph *myGraph, vector<int> &path)
+{
+    int kLimit = max(2, getIntOption("candidates", 16));
+    auto collectEdges = [&](const vector<char> &allowed, int numAllowed, vector<streamEdge> &edges)
+    {
+        int k = min(kLimit, numAllowed - 1);
+        pointGrid grid;
+        grid.build(myGraph, &allowed);
+        vector<int> members;
+        for (int v = 0; v < myGraph->numNodes; v++)
+        {
+            if (allowed[v])
+            {
+                members.push_back(v);
+            };
+        };
+        edges.resize(members.size() * k);
+        vector<int> found(members.size());
+        parallelFor(members.size(), [&](size_t first, size_t last)
+                    {
+            vector<uint64_t> heap(k);
+            for (size_t m = first; m < last; m++)
+            {
+                int v = members[m];
+                found[m] = grid.nearestK(v, k, heap.data());
+                for (int i = 0; i < found[m]; i++)
+                {
+                    int other = heap[i] & 0xffffffff;
+                    edges[m * k + i] = {(uint32_t)(heap[i] >> 32), max(v, other), min(v, other)};
+                };
+            }; });
+
+        // Drop the unused slots of nodes that found fewer than k neighbors.
+        size_t kept = 0;
+        for (size_t m = 0; m < members.size(); m++)
+        {
+            for (int i = 0; i < found[m]; i++)
+            {
+                edges[kept++] = edges[m * k + i];
+            };
+        };
+        edges.resize(kept);
+        return k;
+    };
+    return greedyPasses(myGraph->numNodes, collectEdges, [&](int a, int b)
+                        { return (long long)myGraph->distance(a, b); }, path);
+};
+
+// Runs the original algorithm on a text graph file without ever holding the whole graph in memory, and writes the path into path. Returns the total distance, or -1 (with a message) on failure.
+// The passes of greedyPasses each read the file once: the first keeps only the k cheapest edges of every node (--candidates=K, 16 by default, lowered to fit --memory-limit), and later ones only edges between chain ends and untouched nodes. A last pass reads the distance that closes the tour.
+// Coordinate files hold two numbers per node rather than a row of distances, so they are loaded whole and run through the same passes.
+long long streamGreedy(const string &fileName, vector<int> &path)
+{
+    ifstream firstRow(fileName);
+    string row;
+    getline(firstRow, row);
+    if (firstRow && (countValues(row.data(), row.data() + row.size()) == 2))
+    {
+        graph myGraph;
+        if (!loadGraph(fileName.c_str(), &myGraph))
+        {
+            return -1;
+        };
+        progress() << "The graph has " << myGraph.numNodes << " points" << '\n';
+        return coordinateGreedy(&myGraph, path);
+    };
+
+    uint64_t memoryLimit = getMemoryLimit();
+    size_t chunkBytes = min<uint64_t>((uint64_t)64 << 20, max<uint64_t>((uint64_t)1 << 20, memoryLimit / 16));
+    graphStream stream;
+    if (!stream.open(fileName, chunkBytes))
+    {
+        return -1;
+    };
+    int numNodes = stream.numNodes;
+    progress() << "The graph has " << numNodes << " nodes" << '\n';
+
+    // Per node: the graph's nodes and connections, the groups, the heap bookkeeping and the path (about 64 bytes). Per kept edge: a heap slot and a place in the sorted edge list (20 bytes). A chunk of text and its parsed values take about three times the chunk size.
+    const uint64_t bytesPerNode = 64;
+    const uint64_t bytesPerEdge = sizeof(uint64_t) + sizeof(streamEdge);
+    uint64_t fixedBytes = 3 * chunkBytes + bytesPerNode * numNodes;
+    int kLimit = max(2, getIntOption("candidates", 16));
+    auto collectEdges = [&](const vector<char> &allowed, int numAllowed, vector<streamEdge> &edges)
+    {
+        uint64_t fit = (memoryLimit > fixedBytes) ? (memoryLimit - fixedBytes) / (bytesPerEdge * numAllowed) : 0;
+        int k = min<uint64_t>({(uint64_t)kLimit, (uint64_t)numAllowed - 1, fit});
+        if (k < min(2, numAllowed - 1))
+        {
+            cerr << "A memory limit of " << memoryLimit / (1024 * 1024) << " MB is too small to keep two edges for each of " << numAllowed << " nodes" << endl;
+            return -1;
+        };
+
+        // Keep the k cheapest edges between allowed nodes, in a heap for every allowed node.
+        vector<int> slot(numNodes, -1);
+        for (int v = 0, s = 0; v < numNodes; v++)
+        {
+            if (allowed[v])
+            {
+                slot[v] = s++;
+            };
+        };
+        vector<uint64_t> heaps((size_t)numAllowed * k);
+        vector<int> heapSizes(numAllowed, 0);
+        bool read = stream.forEachRow(allowed, [&](int row, const uint32_t *weights)
+                                      {
+            uint64_t *rowHeap = &heaps[(size_t)slot[row] * k];
+            int &rowHeapSize = heapSizes[slot[row]];
+            for (int col = 0; col < row; col++)
+            {
+                if (allowed[col])
+                {
+                    uint64_t weight = (uint64_t)weights[col] << 32;
+                    offerEdge(rowHeap, rowHeapSize, k, weight | col);
+                    offerEdge(&heaps[(size_t)slot[col] * k], heapSizes[slot[col]], k, weight | row);
+                };
+            }; });
+        if (!read)
+        {
+            return -1;
+        };
+        edges.reserve(heaps.size());
+        for (int v = 0; v < numNodes; v++)
+        {
+            for (int i = 0; allowed[v] && (i < heapSizes[slot[v]]); i++)
+            {
+                uint64_t key = heaps[(size_t)slot[v] * k + i];
+                int other = key & 0xffffffff;
+                edges.push_back({(uint32_t)(key >> 32), max(v, other), min(v, other)});
+            };
+        };
+        return k;
+    };
+
+    // One more pass reads the distance between the two ends of the last chain.
+    auto closingDistance = [&](int nodeOne, int nodeTwo)
+    {
+        long long weight = -1;
+        vector<char> wanted(numNodes, 0);
+        wanted[max(nodeOne, nodeTwo)] = 1;
+        bool read = stream.forEachRow(wanted, [&](int /*row*/, const uint32_t *weights)
+                                      { weight = weights[min(nodeOne, nodeTwo)]; });
+        return read ? weight : -1;
+    };
+    return greedyPasses(numNodes, collectEdges, closingDistance, path);
+};
+
+// The header at the start of a cached candidate list. It is followed by numNodes * k int32 node numbers.
+// The graph file's size and modification time are recorded, so a cache is only used with the exact graph it was built from.
+struct candidateFileHeader
+{
+    char magic[4];     // Always "TSPC".
+    uint32_t version;  // The format version, currently candidateFileVersion.
+    uint32_t numNodes; // The number of nodes in the graph.
+    uint32_t k;        // The number of candidates per node.
+    uint64_t graphSize;
+    int64_t graphModified;
+};
+const char candidateFileMagic[4] = {'T', 'S', 'P', 'C'};
+const uint32_t candidateFileVersion = 1;
+
+// The k cheapest neighbors of every node (its candidates), sorted by distance with ties broken by node number.
+// Any heuristic that only needs to look at nearby nodes can query this instead of scanning a whole row of the matrix.
+class candidateList
+{
+public:
+    int numNodes;
+    int k;
+
+    // The candidates of node i are neighbors[i * k] to neighbors[i * k + k - 1].
+    vector<int> neighbors;
+
+    // Default constructor
+    candidateList()
+    {
+        this->numNodes = 0;
+        this->k = 0;
+    };
+
+    // Returns the first of a node's k candidates.
+    inline const int *of(int nodeIndex) const
+    {
+        return &this->neighbors[(size_t)nodeIndex * this->k];
+    };
+
+    // Builds the lists from the graph's distances, one block of nodes per thread. k is capped at numNodes - 1.
+    void build(const graph *myGraph, int k)
+    {
+        scopedTimer timer("build candidates");
+        this->numNodes = myGraph->numNodes;
+        this->k = max(0, min(k, this->numNodes - 1));
+        this->neighbors.assign((size_t)this->numNodes * this->k, -1);
+        if (this->k == 0)
+        {
+            return;
+        };
+        if (myGraph->coordinates)
+        {
+            // The point grid finds the k nearest points directly; the heap it fills comes out in ascending order once sorted.
+            pointGrid grid;
+            grid.build(myGraph);
+            parallelFor(this->numNodes, [&](size_t firstNode, size_t lastNode)
+                        {
+                vector<uint64_t> heap(this->k);
+                for (size_t i = firstNode; i < lastNode; i++)
+                {
+                    grid.nearestK(i, this->k, heap.data());
+                    sort_heap(heap.begin(), heap.end());
+                    for (int r = 0; r < this->k; r++)
+                    {
+                        this->neighbors[i * this->k + r] = (uint32_t)heap[r];
+                    };
+                }; });
+            return;
+        };
+        parallelFor(this->numNodes, [&](size_t firstNode, size_t lastNode)
+                    {
+            // Rank every neighbor by (distance, node number) packed into one key, then keep the k smallest.
+            vector<uint64_t> keys(this->numNodes - 1);
+            for (size_t i = firstNode; i < lastNode; i++)
+            {
+                size_t numKeys = 0;
+                for (int j = 0; j < this->numNodes; j++)
+                {
+                    if (j != (int)i)
+                    {
+                        keys[numKeys] = ((uint64_t)(uint32_t)myGraph->distance(i, j) << 32) | (uint32_t)j;
+                        numKeys++;
+                    };
+                };
+                nth_element(keys.begin(), keys.begin() + this->k - 1, keys.end());
+                sort(keys.begin(), keys.begin() + this->k);
+                for (int r = 0; r < this->k; r++)
+                {
+                    this->neighbors[i * this->k + r] = (uint32_t)keys[r];
+                };
+            }; });
+    };
+
+    // Returns the name of the cache file for a graph file and k, which sits next to the graph file.
+    static string cacheName(const string &graphFileName, int k)
+    {
+        return graphFileName + ".k" + to_string(k) + ".cand";
+    };
+
+    // Loads the lists from a cache file. Returns false if there is no cache, or if it does not match the graph file (size and modification time), the node count or k.
+    bool load(const string &fileName, const string &graphFileName, int numNodes, int k)
+    {
+        struct stat graphInfo;
+        if (stat(graphFileName.c_str(), &graphInfo) != 0)
+        {
+            return false;
+        };
+        ifstream inFile(fileName, ios::binary);
+        if (!inFile.is_open())
+        {
+            return false;
+        };
+        candidateFileHeader header;
+        inFile.read((char *)&header, sizeof(header));
+        if (!inFile || (memcmp(header.magic, candidateFileMagic, sizeof(header.magic)) != 0) || (header.version != candidateFileVersion) || (header.numNodes != (uint32_t)numNodes) || (header.k != (uint32_t)k) || (header.graphSize != (uint64_t)graphInfo.st_size) || (header.graphModified != (int64_t)graphInfo.st_mtime))
+        {
+            return false;
+        };
+        this->numNodes = numNodes;
+        this->k = k;
+        this->neighbors.resize((size_t)numNodes * k);
+        inFile.read((char *)this->neighbors.data(), this->neighbors.size() * sizeof(int));
+        return (bool)inFile;
+    };
+
+    // Writes the lists to a cache file. Returns false if the file cannot be written.
+    bool save(const string &fileName, const string &graphFileName)
+    {
+        struct stat graphInfo;
+        if (stat(graphFileName.c_str(), &graphInfo) != 0)
+        {
+            return false;
+        };
+        candidateFileHeader header;
+        memcpy(header.magic, candidateFileMagic, sizeof(header.magic));
+        header.version = candidateFileVersion;
+        header.numNodes = this->numNodes;
+        header.k = this->k;
+        header.graphSize = graphInfo.st_size;
+        header.graphModified = graphInfo.st_mtime;
+
+        // Write a temporary file and rename it, so that a batch job reading the cache never sees another job's half-written file.
+        string temporaryName = fileName + ".tmp" + to_string(getpid()) + "." + to_string(hash<thread::id>()(this_thread::get_id()));
+        ofstream outFile(temporaryName, ios::binary);
+        if (!outFile.is_open())
+        {
+            return false;
+        };
+        outFile.write((const char *)&header, sizeof(header));
+        outFile.write((const char *)this->neighbors.data(), this->neighbors.size() * sizeof(int));
+        outFile.close();
+        if (outFile.fail() || (rename(temporaryName.c_str(), fileName.c_str()) != 0))
+        {
+            remove(temporaryName.c_str());
+            return false;
+        };
+        return true;
+    };
+};
+
+// Returns the candidate lists of a graph, reading them from the cache next to the graph file when it matches, and otherwise building them and writing the cache.
+candidateList *getCandidates(graph *myGraph, const string &graphFileName, int k)
+{
+    k = max(0, min(k, myGraph->numNodes - 1));
+    candidateList *candidates = new candidateList();
+    if (graphFileName.empty())
+    {
+        // Generated graphs (see bench mode) have no file to cache next to.
+        candidates->build(myGraph, k);
+        return candidates;
+    };
+    string cacheFileName = candidateList::cacheName(graphFileName, k);
+    if (candidates->load(cacheFileName, graphFileName, myGraph->numNodes, k))
+    {
+        progress() << "Read " << k << " candidates per node from " << cacheFileName << '\n';
+        return candidates;
+    };
+    progress() << "Building " << k << " candidates per node" << '\n';
+    candidates->build(myGraph, k);
+    if (!candidates->save(cacheFileName, graphFileName))
+    {
+        cerr << "Could not cache the candidates in " << cacheFileName << endl;
+    };
+    return candidates;
+};
+
+// The argmin kernels of nearest neighbor. Each returns the index of the smallest row[i] among the nodes whose bit in the packed visited bitset is clear (the lowest index on ties) and stores that value in minimum, or returns -1 if every node has been visited.
+// The vector versions load 8 (AVX2) or 4 (SSE4.1) distances at a time, force the visited lanes to UINT32_MAX with a mask expanded from the bitset, and keep a running lane-wise minimum; a second pass finds the first unvisited lane holding it.
+int argminUnvisitedScalar(const uint32_t *row, const uint64_t *visited, int count, uint32_t &minimum)
+{
+    int smallestIndex = -1;
+    minimum = UINT32_MAX;
+    for (int i = 0; i < count; i++)
+    {
+        if (((visited[i >> 6] >> (i & 63)) & 1) == 0)
+        {
+            if ((smallestIndex == -1) || (row[i] < minimum))
+            {
+                minimum = row[i];
+                smallestIndex = i;
+            };
+        };
+    };
+    return smallestIndex;
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2"))) int argminUnvisitedAvx2(const uint32_t *row, const uint64_t *visited, int count, uint32_t &minimum)
+{
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i smallest = _mm256_set1_epi32(-1);
+    int vectorCount = count & ~7;
+    for (int i = 0; i < vectorCount; i += 8)
+    {
+        int visitedBits = (visited[i >> 6] >> (i & 63)) & 0xFF;
+        __m256i visitedLanes = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(visitedBits), laneBits), laneBits);
+        __m256i values = _mm256_or_si256(_mm256_loadu_si256((const __m256i *)(row + i)), visitedLanes);
+        smallest = _mm256_min_epu32(smallest, values);
+    };
+    __m128i half = _mm_min_epu32(_mm256_castsi256_si128(smallest), _mm256_extracti128_si256(smallest, 1));
+    half = _mm_min_epu32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_min_epu32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t vectorMinimum = _mm_cvtsi128_si32(half);
+
+    // Find the first unvisited lane holding the minimum, then let the tail compete with it.
+    int smallestIndex = -1;
+    __m256i target = _mm256_set1_epi32(vectorMinimum);
+    for (int i = 0; i < vectorCount; i += 8)
+    {
+        int visitedBits = (visited[i >> 6] >> (i & 63)) & 0xFF;
+        int equalLanes = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i *)(row + i)), target))) & ~visitedBits;
+        if (equalLanes != 0)
+        {
+            smallestIndex = i + __builtin_ctz(equalLanes);
+            break;
+        };
+    };
+    minimum = vectorMinimum;
+    for (int i = vectorCount; i < count; i++)
+    {
+        if ((((visited[i >> 6] >> (i & 63)) & 1) == 0) && ((smallestIndex == -1) || (row[i] < minimum)))
+        {
+            minimum = row[i];
+            smallestIndex = i;
+        };
+    };
+    return smallestIndex;
+};
+
+__attribute__((target("sse4.1"))) int argminUnvisitedSse41(const uint32_t *row, const uint64_t *visited, int count, uint32_t &minimum)
+{
+    const __m128i laneBits = _mm_setr_epi32(1, 2, 4, 8);
+    __m128i smallest = _mm_set1_epi32(-1);
+    int vectorCount = count & ~3;
+    for (int i = 0; i < vectorCount; i += 4)
+    {
+        int visitedBits = (visited[i >> 6] >> (i & 63)) & 0xF;
+        __m128i visitedLanes = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(visitedBits), laneBits), laneBits);
+        __m128i values = _mm_or_si128(_mm_loadu_si128((const __m128i *)(row + i)), visitedLanes);
+        smallest = _mm_min_epu32(smallest, values);
+    };
+    smallest = _mm_min_epu32(smallest, _mm_shuffle_epi32(smallest, _MM_SHUFFLE(1, 0, 3, 2)));
+    smallest = _mm_min_epu32(smallest, _mm_shuffle_epi32(smallest, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t vectorMinimum = _mm_cvtsi128_si32(smallest);
+
+    // Find the first unvisited lane holding the minimum, then let the tail compete with it.
+    int smallestIndex = -1;
+    __m128i target = _mm_set1_epi32(vectorMinimum);
+    for (int i = 0; i < vectorCount; i += 4)
+    {
+        int visitedBits = (visited[i >> 6] >> (i & 63)) & 0xF;
+        int equalLanes = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(_mm_loadu_si128((const __m128i *)(row + i)), target))) & ~visitedBits;
+        if (equalLanes != 0)
+        {
+            smallestIndex = i + __builtin_ctz(equalLanes);
+            break;
+        };
+    };
+    minimum = vectorMinimum;
+    for (int i = vectorCount; i < count; i++)
+    {
+        if ((((visited[i >> 6] >> (i & 63)) & 1) == 0) && ((smallestIndex == -1) || (row[i] < minimum)))
+        {
+            minimum = row[i];
+            smallestIndex = i;
+        };
+    };
+    return smallestIndex;
+};
+#endif
+
+// Picks the widest argmin kernel the CPU supports. --no-simd forces the scalar one.
+int (*pickArgminKernel())(const uint32_t *, const uint64_t *, int, uint32_t &)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    if (!hasOption("no-simd"))
+    {
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return argminUnvisitedAvx2;
+        };
+        if (__builtin_cpu_supports("sse4.1"))
+        {
+            return argminUnvisitedSse41;
+        };
+    };
+#endif
+    return argminUnvisitedScalar;
+};
+
+// The argmin kernel nearest neighbor uses, picked once the options are known.
+int (*globalArgminKernel)(const uint32_t *, const uint64_t *, int, uint32_t &) = argminUnvisitedScalar;
+
+// Runs nearest neighbor from startNode. The path (every node once, starting with startNode) is written into path, and the total distance including the way back to startNode is returned.
+// visited is a packed bitset of numNodes bits that the caller owns, so that a worker can reuse its own across many starts. With candidates, each node's candidates are looked at first and the whole row is only scanned once they have all been visited; the path is the same either way.
+// Rows are scanned by gathering them into a contiguous buffer and running the argmin kernel over it. Coordinate graphs ask a point grid of the unvisited nodes instead, which only looks at the points around the current node.
+long long nearestNeighborTour(const graph *myGraph, const candidateList *candidates, int startNode, vector<int> &path, vector<uint64_t> &visited)
+{
+    int numNodes = myGraph->numNodes;
+    path.resize(numNodes);
+    visited.assign((numNodes + 63) / 64, 0);
+    int currentNodeIndex = startNode;
+    long long totalWeight = 0;
+
+    // Coordinate graphs have no rows to scan; a grid of the unvisited points answers the queries instead.
+    vector<uint32_t> row(myGraph->coordinates ? 0 : numNodes);
+    pointGrid unvisited;
+    if (myGraph->coordinates)
+    {
+        unvisited.build(myGraph);
+        unvisited.remove(currentNodeIndex);
+    };
+    visited[currentNodeIndex >> 6] |= (uint64_t)1 << (currentNodeIndex & 63);
+    path[0] = currentNodeIndex;
+    uint64_t numEvaluations = 0;
+    for (int x = 1; x < numNodes; x++)
+    {
+        int smallestNodeIndex = -1;
+        int smallestWeight = INT_MAX;
+        if (candidates != nullptr)
+        {
+            // The first unvisited candidate is the nearest unvisited node.
+            const int *nearby = candidates->of(currentNodeIndex);
+            for (int r = 0; r < candidates->k; r++)
+            {
+                numEvaluations++;
+                if ((visited[nearby[r] >> 6] & ((uint64_t)1 << (nearby[r] & 63))) == 0)
+                {
+                    smallestNodeIndex = nearby[r];
+                    smallestWeight = myGraph->distance(currentNodeIndex, smallestNodeIndex);
+                    break;
+                };
+            };
+        };
+        if ((smallestNodeIndex == -1) && myGraph->coordinates)
+        {
+            smallestNodeIndex = unvisited.nearest(currentNodeIndex);
+            smallestWeight = myGraph->distance(currentNodeIndex, smallestNodeIndex);
+        };
+        if (smallestNodeIndex == -1)
+        {
+            // Scan the whole row with the vectorized argmin kernel.
+            uint32_t minimum;
+            myGraph->gatherRow(currentNodeIndex, row.data());
+            smallestNodeIndex = globalArgminKernel(row.data(), visited.data(), numNodes, minimum);
+            numEvaluations += numNodes;
+            smallestWeight = minimum;
+        };
+        totalWeight += smallestWeight;
+        currentNodeIndex = smallestNodeIndex;
+        visited[currentNodeIndex >> 6] |= (uint64_t)1 << (currentNodeIndex & 63);
+        if (myGraph->coordinates)
+        {
+            unvisited.remove(currentNodeIndex);
+        };
+        path[x] = currentNodeIndex;
+    };
+
+    // Add the distance from the ending node back to the starting node.
+    if (numNodes > 1)
+    {
+        totalWeight += myGraph->distance(currentNodeIndex, startNode);
+    };
+    countStat(nearestEvaluations, numEvaluations + unvisited.evaluations);
+    return totalWeight;
+};
+
+// Runs nearest neighbor from numStarts start nodes spread evenly over the graph and writes the shortest path into bestPath.
+// The starts are shared out over the thread pool. Each worker owns a visited bitset and path buffer and keeps its own best path; the workers' bests are only compared at the end. Ties go to the lower start node, so the result does not depend on the number of threads.
+long long multiStartNearestNeighbor(const graph *myGraph, const candidateList *candidates, int numStarts, vector<int> &bestPath)
+{
+    vector<long long> workerBestWeight(globalThreadCount, LLONG_MAX);
+    vector<int> workerBestStart(globalThreadCount, -1);
+    vector<vector<int>> workerBestPath(globalThreadCount);
+    parallelTasks(numStarts, [&](int worker, size_t task)
+                  {
+        // Every worker keeps its scratch buffers between starts.
+        thread_local vector<int> path;
+        thread_local vector<uint64_t> visited;
+        int startNode = task * myGraph->numNodes / numStarts;
+        long long totalWeight = nearestNeighborTour(myGraph, candidates, startNode, path, visited);
+        if ((totalWeight < workerBestWeight[worker]) || ((totalWeight == workerBestWeight[worker]) && (startNode < workerBestStart[worker])))
+        {
+            workerBestWeight[worker] = totalWeight;
+            workerBestStart[worker] = startNode;
+            workerBestPath[worker] = path;
+        }; });
+    int bestWorker = 0;
+    for (int w = 1; w < globalThreadCount; w++)
+    {
+        if ((workerBestWeight[w] < workerBestWeight[bestWorker]) || ((workerBestWeight[w] == workerBestWeight[bestWorker]) && (workerBestStart[w] < workerBestStart[bestWorker])))
+        {
+            bestWorker = w;
+        };
+    };
+    bestPath = workerBestPath[bestWorker];
+    return workerBestWeight[bestWorker];
+};
+
+// Improves a tour with 2-opt, Or-opt and (when lkDepth is set) Lin-Kernighan style moves.
+// The tour is kept as an array with a position index, so the gain of a move is computed in O(1) from the edges it would change, and only moves that connect a node to one of its candidates are tried. Don't-look bits, kept as a queue of nodes still worth looking at, keep the search on the parts of the tour that have changed.
+class localSearch
+{
+public:
+    const graph *myGraph;
+    const candidateList *candidates;
+    int numNodes;
+    vector<int> tour;     // The node at each position of the tour.
+    vector<int> position; // The position of each node in the tour.
+    long long tourWeight;
+
+    // The nodes still to look at. A node's don't-look bit is off while it is queued.
+    vector<int> queue;
+    vector<char> queued;
+    size_t queueHead;
+
+    // The longest Lin-Kernighan chain to try (0 turns those moves off), and the steps of the chain being tried as (t1, t2, t3, t4).
+    int lkDepth;
+    vector<array<int, 4>> chain;
+
+    // Default constructor. path lists every node once, in tour order.
+    localSearch(const graph *myGraph, const candidateList *candidates, const vector<int> &path)
+    {
+        this->myGraph = myGraph;
+        this->candidates = candidates;
+        this->numNodes = path.size();
+        this->tour = path;
+        this->position.resize(this->numNodes);
+        this->tourWeight = 0;
+        for (int i = 0; i < this->numNodes; i++)
+        {
+            this->position[this->tour[i]] = i;
+            this->tourWeight += distance(this->tour[i], this->tour[(i + 1) % this->numNodes]);
+        };
+        this->queued.assign(this->numNodes, 0);
+        this->queueHead = 0;
+        this->lkDepth = 0;
+    };
+
+    inline long long distance(int a, int b) const
+    {
+        return (a == b) ? 0 : this->myGraph->distance(a, b);
+    };
+
+    inline int next(int nodeIndex) const
+    {
+        int p = this->position[nodeIndex] + 1;
+        return this->tour[(p == this->numNodes) ? 0 : p];
+    };
+
+    inline int previous(int nodeIndex) const
+    {
+        int p = this->position[nodeIndex];
+        return this->tour[(p == 0) ? this->numNodes - 1 : p - 1];
+    };
+
+    // Turns a node's don't-look bit off.
+    void push(int nodeIndex)
+    {
+        if (!this->queued[nodeIndex])
+        {
+            this->queued[nodeIndex] = 1;
+            this->queue.push_back(nodeIndex);
+        };
+    };
+
+    // Reverses the path that runs from `from` to `to` (following next). If the rest of the tour is shorter, that is reversed instead, which gives the same cycle.
+    void reversePath(int from, int to)
+    {
+        int i = this->position[from];
+        int j = this->position[to];
+        int length = j - i;
+        if (length < 0)
+        {
+            length += this->numNodes;
+        };
+        length++;
+        if (2 * length > this->numNodes)
+        {
+            i = this->position[next(to)];
+            j = this->position[previous(from)];
+            length = this->numNodes - length;
+        };
+        for (int k = 0; k < length / 2; k++)
+        {
+            int a = this->tour[i];
+            int b = this->tour[j];
+            this->tour[i] = b;
+            this->position[b] = i;
+            this->tour[j] = a;
+            this->position[a] = j;
+            i = (i + 1 == this->numNodes) ? 0 : i + 1;
+            j = (j == 0) ? this->numNodes - 1 : j - 1;
+        };
+    };
+
+    // Replaces the edges (a, an) and (b, bn) with (a, b) and (an, bn). Either an = next(a) and bn = next(b), or an = previous(a) and bn = previous(b).
+    void move2opt(int a, int an, int b, int bn)
+    {
+        if ((an == b) || (bn == a))
+        {
+            return;
+        };
+        if (next(a) == an)
+        {
+            reversePath(an, b);
+        }
+        else
+        {
+            reversePath(a, bn);
+        };
+    };
+
+    // Tries the 2-opt moves that connect node a to one of its candidates. Applies the first improving one and returns true if there was one.
+    bool improve2opt(int a)
+    {
+        for (int direction = 0; direction < 2; direction++)
+        {
+            int an = (direction == 0) ? next(a) : previous(a);
+            long long removed = distance(a, an);
+            const int *nearby = this->candidates->of(a);
+            for (int r = 0; r < this->candidates->k; r++)
+            {
+                int b = nearby[r];
+                long long gain = removed - distance(a, b);
+                if (gain <= 0)
+                {
+                    break;
+                };
+                int bn = (direction == 0) ? next(b) : previous(b);
+                if ((b == an) || (bn == a))
+                {
+                    continue;
+                };
+                gain += distance(b, bn) - distance(an, bn);
+                if (gain > 0)
+                {
+                    move2opt(a, an, b, bn);
+                    this->tourWeight -= gain;
+                    push(a);
+                    push(an);
+                    push(b);
+                    push(bn);
+                    return true;
+                };
+            };
+        };
+        return false;
+    };
+
+    // Tries to move the segment of 1 to 3 nodes that starts at s1 (following next) between a candidate of one of its ends and that candidate's neighbor, either way round. Applies the first improving move and returns true if there was one.
+    bool improveOrOpt(int s1)
+    {
+        if (this->numNodes < 8)
+        {
+            return false;
+        };
+        int s2 = s1;
+        for (int length = 1; length <= 3; length++)
+        {
+            if (length > 1)
+            {
+                s2 = next(s2);
+            };
+            int p = previous(s1);
+            int nx = next(s2);
+            long long removeGain = distance(p, s1) + distance(s2, nx) - distance(p, nx);
+            if (removeGain <= 0)
+            {
+                continue;
+            };
+            for (int end = 0; end < 2; end++)
+            {
+                int e = (end == 0) ? s1 : s2;
+                int other = (end == 0) ? s2 : s1;
+                const int *nearby = this->candidates->of(e);
+                for (int r = 0; r < this->candidates->k; r++)
+                {
+                    int c = nearby[r];
+                    long long addedToC = distance(c, e);
+                    if (addedToC >= removeGain)
+                    {
+                        break;
+                    };
+                    if (inSegment(c, s1, length))
+                    {
+                        continue;
+                    };
+                    for (int side = 0; side < 2; side++)
+                    {
+                        int d = (side == 0) ? next(c) : previous(c);
+                        if (inSegment(d, s1, length))
+                        {
+                            continue;
+                        };
+                        long long gain = removeGain - addedToC - distance(d, other) + distance(c, d);
+                        if (gain <= 0)
+                        {
+                            continue;
+                        };
+
+                        // Name the edge the segment goes into (cFirst, cSecond) with cSecond = next(cFirst); the segment ends up reversed when s2 sits next to cFirst.
+                        int cFirst = (side == 0) ? c : d;
+                        int cSecond = (side == 0) ? d : c;
+                        bool reversed = ((side == 0) == (e == s2));
+                        if (cSecond == p)
+                        {
+                            continue;
+                        };
+                        moveSegment(p, s1, s2, nx, cFirst, cSecond, reversed || (length == 1));
+                        this->tourWeight -= gain;
+                        push(p);
+                        push(nx);
+                        push(s1);
+                        push(s2);
+                        push(cFirst);
+                        push(cSecond);
+                        return true;
+                    };
+                };
+            };
+        };
+        return false;
+    };
+
+    // Tries a Lin-Kernighan style chain of up to lkDepth 2-opt moves that starts by breaking one of t1's tour edges. Each step joins the loose end t2 to one of its candidates t3 and breaks the edge from t3 to t4 that makes (t4, t1) close the tour again; the chain may pass through longer tours as long as its running gain stays positive. At the end the chain is rolled back to its best closed tour. Returns true if the tour got shorter.
+    bool improveLinKernighan(int t1)
+    {
+        if (this->numNodes < 8)
+        {
+            return false;
+        };
+        for (int direction = 0; direction < 2; direction++)
+        {
+            int t2 = (direction == 0) ? next(t1) : previous(t1);
+            long long openGain = distance(t1, t2);
+            long long bestGain = 0;
+            size_t bestDepth = 0;
+            this->chain.clear();
+            while (this->chain.size() < (size_t)this->lkDepth)
+            {
+                // Pick the step with the best running gain. An edge added earlier in the chain is never broken again.
+                bool t2IsNext = (next(t1) == t2);
+                int bestT3 = -1;
+                int bestT4 = -1;
+                long long bestStepGain = LLONG_MIN;
+                const int *nearby = this->candidates->of(t2);
+                for (int r = 0; r < this->candidates->k; r++)
+                {
+                    int t3 = nearby[r];
+                    long long added = distance(t2, t3);
+                    if (openGain - added <= 0)
+                    {
+                        break;
+                    };
+                    if ((t3 == t1) || (t3 == next(t2)) || (t3 == previous(t2)))
+                    {
+                        continue;
+                    };
+                    int t4 = t2IsNext ? previous(t3) : next(t3);
+                    if (addedInChain(t3, t4))
+                    {
+                        continue;
+                    };
+                    long long stepGain = distance(t3, t4) - added;
+                    if (stepGain > bestStepGain)
+                    {
+                        bestStepGain = stepGain;
+                        bestT3 = t3;
+                        bestT4 = t4;
+                    };
+                };
+                if (bestT3 == -1)
+                {
+                    break;
+                };
+                move2opt(t2, t1, bestT3, bestT4);
+                this->chain.push_back({t1, t2, bestT3, bestT4});
+                openGain += bestStepGain;
+                long long closedGain = openGain - distance(bestT4, t1);
+                if (closedGain > bestGain)
+                {
+                    bestGain = closedGain;
+                    bestDepth = this->chain.size();
+                };
+                t2 = bestT4;
+            };
+
+            // Undo the steps past the best closed tour, last one first.
+            while (this->chain.size() > bestDepth)
+            {
+                const array<int, 4> &step = this->chain.back();
+                move2opt(step[0], step[3], step[1], step[2]);
+                this->chain.pop_back();
+            };
+            if (bestGain > 0)
+            {
+                this->tourWeight -= bestGain;
+                for (int i = 0; i < this->chain.size(); i++)
+                {
+                    for (int j = 0; j < 4; j++)
+                    {
+                        push(this->chain[i][j]);
+                    };
+                };
+                return true;
+            };
+        };
+        return false;
+    };
+
+    // Returns true if the edge (a, b) was added by a step of the current Lin-Kernighan chain.
+    bool addedInChain(int a, int b) const
+    {
+        for (int i = 0; i < this->chain.size(); i++)
+        {
+            int t2 = this->chain[i][1];
+            int t3 = this->chain[i][2];
+            if (((a == t2) && (b == t3)) || ((a == t3) && (b == t2)))
+            {
+                return true;
+            };
+        };
+        return false;
+    };
+
+    // Returns true if a node is one of the `length` nodes starting at s1.
+    bool inSegment(int nodeIndex, int s1, int length) const
+    {
+        int offset = this->position[nodeIndex] - this->position[s1];
+        if (offset < 0)
+        {
+            offset += this->numNodes;
+        };
+        return offset < length;
+    };
+
+    // Moves the segment s1..s2 (between p and nx) between cFirst and cSecond = next(cFirst), as two or three 2-opt moves: cFirst s2..s1 cSecond when reversed, otherwise cFirst s1..s2 cSecond.
+    void moveSegment(int p, int s1, int s2, int nx, int cFirst, int cSecond, bool reversed)
+    {
+        move2opt(p, s1, cFirst, cSecond);
+        move2opt(p, cFirst, nx, s2);
+        if (!reversed)
+        {
+            move2opt(cFirst, s2, s1, cSecond);
+        };
+    };
+
+    // Runs until no node has an improving move left, or until the deadline. Returns the final tour weight.
+    long long run(chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max())
+    {
+        if (this->numNodes < 5)
+        {
+            return this->tourWeight;
+        };
+        for (int i = 0; i < this->numNodes; i++)
+        {
+            push(this->tour[i]);
+        };
+        return runQueued(deadline);
+    };
+
+    // Looks only at the queued nodes (and the ones their moves touch) until none is left or the deadline passes. Returns the final tour weight.
+    long long runQueued(chrono::steady_clock::time_point deadline)
+    {
+        bool timed = (deadline != chrono::steady_clock::time_point::max());
+        for (size_t steps = 1; this->queueHead < this->queue.size(); steps++)
+        {
+            // Reading the clock costs more than a move, so only look at it now and then.
+            if (timed && ((steps & 255) == 0) && (chrono::steady_clock::now() >= deadline))
+            {
+                break;
+            };
+            int a = this->queue[this->queueHead];
+            this->queueHead++;
+            this->queued[a] = 0;
+            if (improve2opt(a) || improveOrOpt(a) || ((this->lkDepth > 0) && improveLinKernighan(a)))
+            {
+                push(a);
+            };
+
+            // Reclaim the consumed part of the queue now and then.
+            if (this->queueHead > (size_t)this->numNodes)
+            {
+                this->queue.erase(this->queue.begin(), this->queue.begin() + this->queueHead);
+                this->queueHead = 0;
+            };
+        };
+        return this->tourWeight;
+    };
+
+    // Applies a random double-bridge kick inside a window of at most 50 positions: the part A B C D of the tour becomes A C B D, where B and C are the two short segments after a random position. Only the six nodes at the changed edges are queued, so the local search that follows stays near the kick. Needs at least 8 nodes.
+    void kick(mt19937 &random)
+    {
+        int window = min(this->numNodes - 1, 50);
+        int p0 = uniform_int_distribution<int>(0, this->numNodes - 1 - window)(random);
+        int p1 = p0 + uniform_int_distribution<int>(1, window - 2)(random);
+        int p2 = uniform_int_distribution<int>(p1 + 1, p0 + window - 1)(random);
+        int a0 = this->tour[p0];
+        int b0 = this->tour[p0 + 1];
+        int b1 = this->tour[p1];
+        int c0 = this->tour[p1 + 1];
+        int c1 = this->tour[p2];
+        int d0 = this->tour[p2 + 1];
+        this->tourWeight += distance(a0, c0) + distance(c1, b0) + distance(b1, d0) - distance(a0, b0) - distance(b1, c0) - distance(c1, d0);
+        rotate(this->tour.begin() + p0 + 1, this->tour.begin() + p1 + 1, this->tour.begin() + p2 + 1);
+        for (int i = p0 + 1; i <= p2; i++)
+        {
+            this->position[this->tour[i]] = i;
+        };
+        push(a0);
+        push(b0);
+        push(b1);
+        push(c0);
+        push(c1);
+        push(d0);
+    };
+
+    // Writes the tour into path, starting from startNode.
+    void getPath(vector<int> &path, int startNode) const
+    {
+        path.resize(this->numNodes);
+        int p = this->position[startNode];
+        for (int i = 0; i < this->numNodes; i++)
+        {
+            path[i] = this->tour[p];
+            p = (p + 1 == this->numNodes) ? 0 : p + 1;
+        };
+    };
+};
+
+// Writes a path to a .sol file: every node once, then the starting node again. Returns false if the file cannot be written.
+bool writePathFile(const string &fileName, const vector<int> &path)
+{
+    scopedTimer timer("write tour");
+    ofstream outFile(fileName);
+    if (!outFile.is_open())
+    {
+        return false;
+    };
+    for (int i = 0; i < path.size(); i++)
+    {
+        outFile << path.at(i) << " ";
+    };
+    outFile << path.at(0) << " ";
+    outFile.close();
+    return true;
+};
+
+// Keeps improving the tour in search until the deadline (iterated local search). Each round kicks the best tour found so far and lets the local search repair the tour around the kick; the result is kept unless it is longer than the best tour, in which case the best tour is restored.
+// While the best tour keeps getting shorter, checkpoint is called with it every checkpointSeconds, so a job that is stopped early still leaves its best tour behind. Returns the weight of the best tour, which search holds at the end.
+long long iteratedLocalSearch(localSearch &search, chrono::steady_clock::time_point deadline, double checkpointSeconds, mt19937 &random, const function<void(const localSearch &)> &checkpoint)
+{
+    search.run(deadline);
+    vector<int> bestTour = search.tour;
+    vector<int> bestPosition = search.position;
+    long long bestWeight = search.tourWeight;
+    long long checkpointWeight = LLONG_MAX;
+    auto nextCheckpoint = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(checkpointSeconds));
+    long long rounds = 0;
+    while ((search.numNodes >= 8) && (chrono::steady_clock::now() < deadline))
+    {
+        search.kick(random);
+        search.runQueued(deadline);
+        rounds++;
+        if (search.tourWeight <= bestWeight)
+        {
+            bestWeight = search.tourWeight;
+            bestTour = search.tour;
+            bestPosition = search.position;
+        }
+        else
+        {
+            search.tour = bestTour;
+            search.position = bestPosition;
+            search.tourWeight = bestWeight;
+        };
+        if ((chrono::steady_clock::now() >= nextCheckpoint) && (bestWeight < checkpointWeight))
+        {
+            checkpoint(search);
+            checkpointWeight = bestWeight;
+            nextCheckpoint = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(checkpointSeconds));
+        };
+    };
+
+    // A run cut short by the deadline can leave the tour longer than the best one.
+    if (search.tourWeight > bestWeight)
+    {
+        search.tour = bestTour;
+        search.position = bestPosition;
+        search.tourWeight = bestWeight;
+    };
+    progress() << "Ran " << rounds << " kick rounds" << '\n';
+    return bestWeight;
+};
+
+// Runs the improvement stage on a path (every node once, in tour order) and returns the improved total distance. The path keeps its first node.
+// The candidates come from getCandidates (--candidates=K, 8 by default), so they are cached next to the graph file.
+// With --time-limit=SECONDS the stage also uses Lin-Kernighan style chains of up to --lk-depth=D 2-opt moves (5 by default) and keeps kicking and repairing the tour until the time is up. Every --checkpoint=SECONDS (10 by default) the best tour so far is written to the .sol file named by solPrefix and its distance, replacing the previous checkpoint. --seed=N picks the kicks.
+long long improveTour(graph *myGraph, const string &graphFileName, vector<int> &path, const string &solPrefix)
+{
+    scopedTimer timer("improve");
+    auto startTime = chrono::steady_clock::now();
+    candidateList *candidates = getCandidates(myGraph, graphFileName, getIntOption("candidates", 8));
+    localSearch search(myGraph, candidates, path);
+    long long startWeight = search.tourWeight;
+    long long totalWeight;
+    if (!hasOption("time-limit"))
+    {
+        progress() << "Improving the path with 2-opt and Or-opt moves" << '\n';
+        totalWeight = search.run();
+    }
+    else
+    {
+        double timeLimit = getDoubleOption("time-limit", 0);
+        progress() << "Improving the path with 2-opt, Or-opt and Lin-Kernighan moves for " << timeLimit << " seconds" << '\n';
+        search.lkDepth = max(1, getIntOption("lk-depth", 5));
+        mt19937 random(getIntOption("seed", 1));
+        auto deadline = startTime + chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(timeLimit));
+        string checkpointName;
+        totalWeight = iteratedLocalSearch(search, deadline, getDoubleOption("checkpoint", 10), random, [&](const localSearch &best)
+                                          {
+            vector<int> bestPath;
+            best.getPath(bestPath, path.at(0));
+            string fileName = solPrefix + to_string(best.tourWeight) + "_wcjunkins.sol";
+            if (writePathFile(fileName, bestPath))
+            {
+                if (!checkpointName.empty() && (checkpointName != fileName))
+                {
+                    remove(checkpointName.c_str());
+                };
+                checkpointName = fileName;
+                progress() << "Checkpoint: " << best.tourWeight << " saved to " << fileName << '\n';
+            }; });
+
+        // The final path is written by the caller, so the last checkpoint is only kept when it has the same name.
+        if (!checkpointName.empty() && (checkpointName != solPrefix + to_string(totalWeight) + "_wcjunkins.sol"))
+        {
+            remove(checkpointName.c_str());
+        };
+    };
+    search.getPath(path, path.at(0));
+    progress() << "Improved the path from " << startWeight << " to " << totalWeight << '\n';
+    delete candidates;
+    return totalWeight;
+};
+
+// Extends a path of `depth` nodes by every unvisited node in turn, carrying the path's length along, and keeps the shortest complete tour in bestWeight and bestPath (the first in lexicographic order among equally short tours). A path is cut off once it is longer than sharedBest, the shortest tour any thread has found. numTours counts the complete tours that were added up.
+void bruteForceExtend(const graph *myGraph, vector<int> &path, vector<char> &used, int depth, long long weight, atomic<long long> &sharedBest, long long &bestWeight, vector<int> &bestPath, uint64_t &numTours)
+{
+    if (weight > sharedBest.load(memory_order_relaxed))
+    {
+        return;
+    };
+    int numNodes = myGraph->numNodes;
+    if (depth == numNodes)
+    {
+        long long totalWeight = weight + myGraph->distance(path.back(), path.at(0));
+        numTours++;
+        if ((totalWeight < bestWeight) || ((totalWeight == bestWeight) && (path < bestPath)))
+        {
+            bestWeight = totalWeight;
+            bestPath = path;
+            long long shared = sharedBest.load();
+            while ((totalWeight < shared) && !sharedBest.compare_exchange_weak(shared, totalWeight))
+            {
+            };
+        };
+        return;
+    };
+    for (int v = 1; v < numNodes; v++)
+    {
+        if (used[v])
+        {
+            continue;
+        };
+        used[v] = 1;
+        path[depth] = v;
+        bruteForceExtend(myGraph, path, used, depth + 1, weight + myGraph->distance(path[depth - 1], v), sharedBest, bestWeight, bestPath, numTours);
+        used[v] = 0;
+    };
+};
+
+// Tries every tour that starts at node 0 and writes the shortest one into bestPath. Among equally short tours it picks the first in lexicographic order, so the result does not depend on the number of threads. Returns its total distance.
+// The tours are split by the two nodes that follow node 0, and those prefixes are shared out over the thread pool. Only a path that is strictly longer than the best tour is cut off, so an equally short tour that comes first in order is still found.
+long long bruteForce(const graph *myGraph, vector<int> &bestPath)
+{
+    int numNodes = myGraph->numNodes;
+    bestPath.assign(1, 0);
+    if (numNodes < 2)
+    {
+        return 0;
+    };
+    scopedTimer timer("brute force");
+    atomic<long long> sharedBest(LLONG_MAX);
+    vector<long long> workerBestWeight(globalThreadCount, LLONG_MAX);
+    vector<vector<int>> workerBestPath(globalThreadCount);
+    vector<uint64_t> workerTours(globalThreadCount, 0);
+    size_t numTasks = (numNodes >= 3) ? (size_t)(numNodes - 1) * (numNodes - 2) : 1;
+    parallelTasks(numTasks, [&](int worker, size_t task)
+                  {
+        vector<int> path(numNodes, 0);
+        vector<char> used(numNodes, 0);
+        used[0] = 1;
+        if (numNodes < 3)
+        {
+            bruteForceExtend(myGraph, path, used, 1, 0, sharedBest, workerBestWeight[worker], workerBestPath[worker], workerTours[worker]);
+            return;
+        };
+
+        // Task t starts 0, a, b with a = 1 + t / (numNodes - 2) and b the (t % (numNodes - 2))-th other node, in order.
+        int a = 1 + task / (numNodes - 2);
+        int b = 1 + task % (numNodes - 2);
+        if (b >= a)
+        {
+            b++;
+        };
+        path[1] = a;
+        path[2] = b;
+        used[a] = 1;
+        used[b] = 1;
+        long long weight = (long long)myGraph->distance(0, a) + myGraph->distance(a, b);
+        bruteForceExtend(myGraph, path, used, 3, weight, sharedBest, workerBestWeight[worker], workerBestPath[worker], workerTours[worker]); });
+    for (int w = 0; w < globalThreadCount; w++)
+    {
+        countStat(bruteTours, workerTours[w]);
+    };
+    int bestWorker = 0;
+    for (int w = 1; w < globalThreadCount; w++)
+    {
+        if ((workerBestWeight[w] < workerBestWeight[bestWorker]) || ((workerBestWeight[w] == workerBestWeight[bestWorker]) && (workerBestPath[w] < workerBestPath[bestWorker])))
+        {
+            bestWorker = w;
+        };
+    };
+    bestPath = workerBestPath[bestWorker];
+    return workerBestWeight[bestWorker];
+};
+
+// Held-Karp keeps, for every set S of nodes other than node 0 and every node j in S, the shortest path that starts at node 0, visits exactly S and ends at j.
+// The table holds one row of numNodes - 1 costs per set, so the costs a row is built from (the row of S without j) are read in one sweep. Nodes outside a set hold heldKarpUnreached, which lets that sweep run over every node without testing bits.
+template <typename costType>
+const costType heldKarpUnreached = numeric_limits<costType>::max() / 2;
+
+// Returns the bytes the Held-Karp table needs for a graph, or 0 if that does not even fit in 64 bits.
+uint64_t heldKarpMemory(int numNodes, int costWidth)
+{
+    int others = numNodes - 1;
+    if ((others < 1) || (others > 48))
+    {
+        return (others < 1) ? 1 : 0;
+    };
+    return ((uint64_t)1 << others) * others * costWidth;
+};
+
+// Returns the number of ways to pick count things out of total.
+uint64_t binomial(int total, int count)
+{
+    if ((count < 0) || (count > total))
+    {
+        return 0;
+    };
+    uint64_t result = 1;
+    for (int i = 1; i <= count; i++)
+    {
+        result = result * (total - count + i) / i;
+    };
+    return result;
+};
+
+// Returns the set of `count` bits out of `total` that comes `rank`-th in increasing order of value.
+uint64_t unrankSubset(uint64_t rank, int total, int count)
+{
+    uint64_t subset = 0;
+    for (int i = count; i > 0; i--)
+    {
+        int bit = i - 1;
+        while ((bit + 1 < total) && (binomial(bit + 1, i) <= rank))
+        {
+            bit++;
+        };
+        rank -= binomial(bit, i);
+        subset |= (uint64_t)1 << bit;
+        total = bit;
+    };
+    return subset;
+};
+
+// Returns the next larger number with the same number of bits set (Gosper's hack).
+inline uint64_t nextSubset(uint64_t subset)
+{
+    uint64_t lowest = subset & (~subset + 1);
+    uint64_t ripple = subset + lowest;
+    return (((ripple ^ subset) >> 2) / lowest) | ripple;
+};
+
+// Solves the graph exactly with the Held-Karp dynamic program and writes the shortest tour, starting at node 0, into path. Returns its total distance.
+// The sets are filled in layers of equal size; every set in a layer only needs the layer before it, so each layer is shared out over the threads. The tour is then read back out of the table, so no table of predecessors is needed. The caller checks that the table fits in memory.
+template <typename costType>
+long long heldKarp(const graph *myGraph, vector<int> &path)
+{
+    int numNodes = myGraph->numNodes;
+    int others = numNodes - 1;
+    path.assign(1, 0);
+    if (others < 1)
+    {
+        return 0;
+    };
+
+    // Node i + 1 is bit i. toNode[j * others + k] is the distance from bit k to bit j, so the costs into j are contiguous.
+    vector<costType> toNode((size_t)others * others, 0);
+    for (int j = 0; j < others; j++)
+    {
+        for (int k = 0; k < others; k++)
+        {
+            if (j != k)
+            {
+                toNode[(size_t)j * others + k] = myGraph->distance(k + 1, j + 1);
+            };
+        };
+    };
+
+    // The sets with one node are the paths straight out of node 0.
+    const costType unreached = heldKarpUnreached<costType>;
+    vector<costType> table(((size_t)1 << others) * others);
+    for (int j = 0; j < others; j++)
+    {
+        costType *row = &table[((size_t)1 << j) * others];
+        for (int k = 0; k < others; k++)
+        {
+            row[k] = (k == j) ? myGraph->distance(0, j + 1) : unreached;
+        };
+    };
+
+    for (int layer = 2; layer <= others; layer++)
+    {
+        parallelFor(binomial(others, layer), [&](size_t begin, size_t end)
+                    {
+            uint64_t subset = unrankSubset(begin, others, layer);
+            for (size_t s = begin; s < end; s++, subset = nextSubset(subset))
+            {
+                costType *row = &table[subset * others];
+                for (int j = 0; j < others; j++)
+                {
+                    if (!((subset >> j) & 1))
+                    {
+                        row[j] = unreached;
+                        continue;
+                    };
+                    const costType *before = &table[(subset ^ ((uint64_t)1 << j)) * others];
+                    const costType *into = &toNode[(size_t)j * others];
+                    costType best = unreached;
+                    for (int k = 0; k < others; k++)
+                    {
+                        costType cost = before[k] + into[k];
+                        best = (cost < best) ? cost : best;
+                    };
+                    row[j] = best;
+                };
+            }; });
+    };
+
+    // Close the tour back to node 0, then walk back through the table: the node before j is any k whose path plus the hop to j gives the stored cost (the lowest such k, so ties always resolve the same way).
+    uint64_t subset = ((uint64_t)1 << others) - 1;
+    long long totalWeight = LLONG_MAX;
+    int last = 0;
+    for (int j = 0; j < others; j++)
+    {
+        long long cost = (long long)table[subset * others + j] + myGraph->distance(j + 1, 0);
+        if (cost < totalWeight)
+        {
+            totalWeight = cost;
+            last = j;
+        };
+    };
+    vector<int> backwards;
+    while (true)
+    {
+        backwards.push_back(last + 1);
+        costType cost = table[subset * others + last];
+        subset ^= (uint64_t)1 << last;
+        if (subset == 0)
+        {
+            break;
+        };
+        const costType *before = &table[subset * others];
+        const costType *into = &toNode[(size_t)last * others];
+        for (int k = 0; k < others; k++)
+        {
+            if (((subset >> k) & 1) && (before[k] + into[k] == cost))
+            {
+                last = k;
+                break;
+            };
+        };
+    };
+    path.insert(path.end(), backwards.rbegin(), backwards.rend());
+    return totalWeight;
+};
+
+// Solves graphs of up to 64 nodes exactly by branch and bound. A subproblem is a path that starts at node 0; its children extend the path by one unvisited node.
+// A subproblem is pruned when a lower bound on every tour that starts with its path is no shorter than the best tour found so far. The bound is the path's length plus a bound on the rest of the tour: a spanning tree of the unvisited nodes plus the cheapest edges that join it to both ends of the path. The edge weights are first shifted by node penalties that make the 1-tree bound of the whole graph as tight as possible (subgradient ascent, as in Held and Karp), which lifts every bound in the search and does not change which tour is shortest.
+// Every worker keeps its subproblems in a deque of its own and works depth first from the back. A worker with an empty deque steals from the front of another worker's deque, where the subproblems closest to the root (and so the most work) are.
+class branchAndBound
+{
+public:
+    static const int maxNodes = 64;
+
+    struct subproblem
+    {
+        long long weight;  // The length of the path so far.
+        long long bound;   // A lower bound on every tour that starts with the path.
+        uint64_t visited;  // The nodes on the path.
+        int depth;         // The number of nodes on the path.
+        array<uint8_t, maxNodes> path;
+    };
+
+    struct workQueue
+    {
+        mutex lock;
+        deque<subproblem> tasks;
+    };
+
+    const graph *myGraph;
+    int numNodes;
+    vector<double> penalty; // The penalty of each node.
+    vector<double> shifted; // The edge weights plus the penalties of both ends, numNodes x numNodes.
+    double rootBound;
+
+    atomic<long long> bestWeight;
+    mutex bestLock;
+    vector<int> bestPath;
+
+    vector<unique_ptr<workQueue>> queues;
+    atomic<long long> pendingTasks; // Subproblems pushed but not yet finished.
+    vector<long long> explored;     // The subproblems each worker has expanded.
+
+    // Default constructor. path is the starting tour (every node once) and weight its total distance.
+    branchAndBound(const graph *myGraph, const vector<int> &path, long long weight)
+    {
+        this->myGraph = myGraph;
+        this->numNodes = myGraph->numNodes;
+        this->bestWeight = weight;
+        this->bestPath = path;
+        this->pendingTasks = 0;
+        this->penalty.assign(this->numNodes, 0);
+        this->rootBound = 0;
+    };
+
+    // Fills shifted from the current penalties.
+    void shiftWeights()
+    {
+        this->shifted.assign((size_t)this->numNodes * this->numNodes, 0);
+        for (int i = 0; i < this->numNodes; i++)
+        {
+            for (int j = 0; j < this->numNodes; j++)
+            {
+                if (i != j)
+                {
+                    this->shifted[(size_t)i * this->numNodes + j] = this->myGraph->distance(i, j) + this->penalty[i] + this->penalty[j];
+                };
+            };
+        };
+    };
+
+    // Returns the length of the 1-tree of the whole graph under the shifted weights (a spanning tree of nodes 1 and up, plus the two cheapest edges at node 0) and counts how many tree edges touch each node.
+    double oneTree(vector<int> &degree)
+    {
+        int n = this->numNodes;
+        degree.assign(n, 0);
+        vector<double> key(n, numeric_limits<double>::infinity());
+        vector<int> parent(n, -1);
+        vector<char> inTree(n, 0);
+        double length = 0;
+        key[1] = 0;
+        for (int added = 1; added < n; added++)
+        {
+            int u = -1;
+            for (int v = 1; v < n; v++)
+            {
+                if (!inTree[v] && ((u == -1) || (key[v] < key[u])))
+                {
+                    u = v;
+                };
+            };
+            inTree[u] = 1;
+            if (parent[u] != -1)
+            {
+                length += key[u];
+                degree[u]++;
+                degree[parent[u]]++;
+            };
+            for (int v = 1; v < n; v++)
+            {
+                double w = this->shifted[(size_t)u * n + v];
+                if (!inTree[v] && (w < key[v]))
+                {
+                    key[v] = w;
+                    parent[v] = u;
+                };
+            };
+        };
+        int first = -1;
+        int second = -1;
+        for (int v = 1; v < n; v++)
+        {
+            double w = this->shifted[v];
+            if ((first == -1) || (w < this->shifted[first]))
+            {
+                second = first;
+                first = v;
+            }
+            else if ((second == -1) || (w < this->shifted[second]))
+            {
+                second = v;
+            };
+        };
+        length += this->shifted[first] + this->shifted[second];
+        degree[0] = 2;
+        degree[first]++;
+        degree[second]++;
+        return length;
+    };
+
+    // Searches for the node penalties that give the tightest 1-tree bound, by subgradient ascent: a node with more than two tree edges gets dearer, a node with one gets cheaper.
+    void computePenalties()
+    {
+        int n = this->numNodes;
+        vector<int> degree;
+        vector<double> bestPenalty = this->penalty;
+        double bestBound = -numeric_limits<double>::infinity();
+        double stepScale = 2;
+        int sinceImproved = 0;
+        for (int iteration = 0; (iteration < 100 * n) && (stepScale > 1e-6); iteration++)
+        {
+            shiftWeights();
+            double penaltySum = 0;
+            for (int i = 0; i < n; i++)
+            {
+                penaltySum += this->penalty[i];
+            };
+            double bound = oneTree(degree) - 2 * penaltySum;
+            if (bound > bestBound + 1e-9)
+            {
+                bestBound = bound;
+                bestPenalty = this->penalty;
+                sinceImproved = 0;
+            }
+            else if (++sinceImproved >= max(5, n / 2))
+            {
+                stepScale /= 2;
+                sinceImproved = 0;
+            };
+            long long norm = 0;
+            for (int i = 0; i < n; i++)
+            {
+                norm += (long long)(degree[i] - 2) * (degree[i] - 2);
+            };
+
+            // A 1-tree where every node has two edges is a tour, so the bound cannot get any better.
+            if ((norm == 0) || (bestBound >= this->bestWeight))
+            {
+                break;
+            };
+            double step = stepScale * (this->bestWeight - bound) / norm;
+            for (int i = 0; i < n; i++)
+            {
+                this->penalty[i] += step * (degree[i] - 2);
+            };
+        };
+        this->penalty = bestPenalty;
+        this->rootBound = bestBound;
+        shiftWeights();
+    };
+
+    // Rounds a bound up to a whole distance, allowing for the rounding error of the shifted weights.
+    static long long roundBound(double bound)
+    {
+        return (long long)ceil(bound - 1e-6 - 1e-9 * fabs(bound));
+    };
+
+    // Returns a lower bound on every tour that starts with the given path.
+    long long lowerBound(long long weight, uint64_t visited, int last) const
+    {
+        int n = this->numNodes;
+        thread_local vector<int> open;
+        thread_local vector<double> key;
+        open.clear();
+        double penaltySum = 0;
+        for (int v = 0; v < n; v++)
+        {
+            if (!((visited >> v) & 1))
+            {
+                open.push_back(v);
+                penaltySum += this->penalty[v];
+            };
+        };
+        if (open.empty())
+        {
+            return weight + this->myGraph->distance(last, 0);
+        };
+
+        // The rest of the tour runs from the last node through every open node and back to node 0: a spanning tree of the open nodes plus an edge from each end.
+        const double *fromLast = &this->shifted[(size_t)last * n];
+        const double *fromStart = &this->shifted[0];
+        double toLast = numeric_limits<double>::infinity();
+        double toStart = numeric_limits<double>::infinity();
+        for (int i = 0; i < open.size(); i++)
+        {
+            toLast = min(toLast, fromLast[open[i]]);
+            toStart = min(toStart, fromStart[open[i]]);
+        };
+        double length = toLast + toStart;
+        int count = open.size();
+        key.assign(count, numeric_limits<double>::infinity());
+        key[0] = 0;
+        for (int added = 0; added < count; added++)
+        {
+            int best = added;
+            for (int i = added + 1; i < count; i++)
+            {
+                if (key[i] < key[best])
+                {
+                    best = i;
+                };
+            };
+            swap(key[added], key[best]);
+            swap(open[added], open[best]);
+            length += key[added];
+            const double *row = &this->shifted[(size_t)open[added] * n];
+            for (int i = added + 1; i < count; i++)
+            {
+                key[i] = min(key[i], row[open[i]]);
+            };
+        };
+        return weight + roundBound(length - this->penalty[last] - this->penalty[0] - 2 * penaltySum);
+    };
+
+    // Records a tour if it is shorter than the best one so far.
+    void offerTour(const subproblem &task, long long weight)
+    {
+        lock_guard<mutex> guard(this->bestLock);
+        if (weight < this->bestWeight)
+        {
+            this->bestWeight = weight;
+            this->bestPath.assign(task.path.begin(), task.path.begin() + task.depth);
+        };
+    };
+
+    // Expands one subproblem: its children that can still beat the best tour go on the back of the worker's deque, the most promising last so that it is taken first.
+    void expand(int worker, const subproblem &task)
+    {
+        if (task.bound >= this->bestWeight)
+        {
+            return;
+        };
+        this->explored[worker]++;
+        int last = task.path[task.depth - 1];
+        thread_local vector<subproblem> children;
+        children.clear();
+        for (int v = 0; v < this->numNodes; v++)
+        {
+            if ((task.visited >> v) & 1)
+            {
+                continue;
+            };
+            subproblem child = task;
+            child.weight += this->myGraph->distance(last, v);
+            child.visited |= (uint64_t)1 << v;
+            child.path[child.depth] = v;
+            child.depth++;
+            if (child.depth == this->numNodes)
+            {
+                offerTour(child, child.weight + this->myGraph->distance(v, 0));
+                continue;
+            };
+            child.bound = lowerBound(child.weight, child.visited, v);
+            if (child.bound < this->bestWeight)
+            {
+                children.push_back(child);
+            };
+        };
+        if (children.empty())
+        {
+            return;
+        };
+        sort(children.begin(), children.end(), [](const subproblem &a, const subproblem &b)
+             { return a.bound > b.bound; });
+        this->pendingTasks += children.size();
+        workQueue &queue = *this->queues[worker];
+        lock_guard<mutex> guard(queue.lock);
+        queue.tasks.insert(queue.tasks.end(), children.begin(), children.end());
+    };
+
+    // Takes subproblems from the worker's own deque, or steals them, until there are none left anywhere.
+    void work(int worker)
+    {
+        int numWorkers = this->queues.size();
+        while (true)
+        {
+            subproblem task;
+            bool found = false;
+            {
+                workQueue &own = *this->queues[worker];
+                lock_guard<mutex> guard(own.lock);
+                if (!own.tasks.empty())
+                {
+                    task = own.tasks.back();
+                    own.tasks.pop_back();
+                    found = true;
+                };
+            };
+            for (int offset = 1; !found && (offset < numWorkers); offset++)
+            {
+                workQueue &victim = *this->queues[(worker + offset) % numWorkers];
+                lock_guard<mutex> guard(victim.lock);
+                if (!victim.tasks.empty())
+                {
+                    task = victim.tasks.front();
+                    victim.tasks.pop_front();
+                    found = true;
+                };
+            };
+            if (!found)
+            {
+                if (this->pendingTasks == 0)
+                {
+                    return;
+                };
+                this_thread::yield();
+                continue;
+            };
+            expand(worker, task);
+            this->pendingTasks--;
+        };
+    };
+
+    // Runs the search and writes the shortest tour into path. Returns its total distance.
+    long long solve(vector<int> &path)
+    {
+        if (this->numNodes >= 3)
+        {
+            computePenalties();
+            progress() << "Root lower bound: " << roundBound(this->rootBound) << '\n';
+        }
+        else
+        {
+            shiftWeights();
+        };
+        int numWorkers = globalThreadCount;
+        this->queues.clear();
+        for (int w = 0; w < numWorkers; w++)
+        {
+            this->queues.push_back(make_unique<workQueue>());
+        };
+        this->explored.assign(numWorkers, 0);
+
+        subproblem root;
+        root.weight = 0;
+        root.visited = 1;
+        root.depth = 1;
+        root.path[0] = 0;
+        root.bound = (this->numNodes >= 3) ? roundBound(this->rootBound) : 0;
+        if (this->numNodes > 1)
+        {
+            this->queues[0]->tasks.push_back(root);
+            this->pendingTasks = 1;
+        };
+        parallelFor(numWorkers, [&](size_t begin, size_t end)
+                    {
+            for (size_t w = begin; w < end; w++)
+            {
+                work(w);
+            }; });
+
+        long long total = 0;
+        for (int w = 0; w < numWorkers; w++)
+        {
+            total += this->explored[w];
+        };
+        progress() << "Explored " << total << " subproblems" << '\n';
+        path = this->bestPath;
+        return this->bestWeight;
+    };
+};
+
+// Runs the original algorithm on a loaded graph and writes the path (every node once, starting with the first remaining leader node) into path. Returns the total distance, or -1 (with a message) if the graph is too large.
+// Every connection is printed as it is made.
+long long originalTour(graph *myGraph, vector<int> &path)
+{
+    scopedTimer timer("original algorithm");
+    if (myGraph->coordinates)
+    {
+        // There is no matrix to sort, so the connections are made along each point's nearest neighbors instead.
+        return coordinateGreedy(myGraph, path);
+    };
+    if (myGraph->numNodes > graph::maxEdgeKeyNodes)
+    {
+        cerr << "The original algorithm supports at most " << graph::maxEdgeKeyNodes << " nodes" << endl;
+        return -1;
+    };
+    progress() << "Sorting weight values" << '\n';
+    edgeBatches sortedEdges(myGraph);
+
+    // Start with the smallest weight in the sorted edges. Iterate through each edge in order, until n - 1 connections have been made; after that, only the two end nodes are left to join.
+    disjointSet nodeGroups(myGraph->numNodes);
+    myGraph->connections.assign(2 * myGraph->numNodes, -1);
+    long long totalWeight = 0;
+    int numConnections = 0;
+    uint64_t numScanned = 0;
+    vector<uint64_t> batch;
+    for (size_t i = 0; numConnections < myGraph->numNodes - 1; i++)
+    {
+        // Fetch the next batch of sorted edges once this one is used up.
+        if (i == batch.size())
+        {
+            if (!sortedEdges.nextBatch(batch))
+            {
+                break;
+            };
+            i = 0;
+        };
+        numScanned++;
+        int currentWeight = graph::edgeWeight(batch[i]);
+        int currentLeftNodeNumber;
+        int currentRightNodeNumber;
+        graph::edgeNodes(batch[i], currentLeftNodeNumber, currentRightNodeNumber);
+        if (greedyConnect(myGraph, nodeGroups, currentLeftNodeNumber, currentRightNodeNumber))
+        {
+            progress(2) << currentLeftNodeNumber << "---" << currentWeight << "-->" << currentRightNodeNumber << '\n';
+            numConnections++;
+            totalWeight += currentWeight;
+        };
+    };
+
+    progress() << "Sorted " << sortedEdges.edgesHandedOut << " of " << sortedEdges.numEdges << " weight values" << '\n';
+    countStat(edgesScanned, numScanned);
+    countStat(edgesAccepted, numConnections);
+    nodeGroups.countStats();
+
+    // Connect the two end nodes. These will be the only leader nodes left (a graph of one node has none, and its path is just that node).
+    int nodeOne = -1;
+    int nodeTwo = 0;
+    for (int i = 0; i < myGraph->nodes.size(); i++)
+    {
+        if (myGraph->nodes.at(i)->nodeType == 1)
+        {
+            if (nodeOne == -1)
+            {
+                nodeOne = myGraph->nodes.at(i)->nodeName;
+            };
+            nodeTwo = myGraph->nodes.at(i)->nodeName;
+        };
+    };
+    if (nodeOne == -1)
+    {
+        path.assign(1, 0);
+        return 0;
+    };
+    myGraph->connect(nodeOne, nodeTwo);
+    totalWeight += myGraph->distance(nodeOne, nodeTwo);
+
+    // Starting with nodeOne (the first remaining leader node), walk the connections to retrace our path.
+    scopedTimer retraceTimer("retrace path");
+    myGraph->retracePath(nodeOne);
+    path.assign(myGraph->pathTaken.begin(), myGraph->pathTaken.end() - 1);
+    return totalWeight;
+};
+
+// Runs nearest neighbor on a loaded graph and writes the path into path. Returns the total distance.
+// Starting with node 0, perform nearest neighbor. With --starts=N, run it from N start nodes spread evenly over the graph instead (--starts=all tries every node) on all threads, and keep the shortest path.
+// With --candidates=K, look at each node's K cheapest neighbors first and only scan the whole row once they have all been visited. The path is the same either way.
+long long nearestTour(graph *myGraph, const string &graphFileName, vector<int> &path)
+{
+    scopedTimer timer("nearest neighbor");
+    candidateList *candidates = nullptr;
+    if (hasOption("candidates"))
+    {
+        candidates = getCandidates(myGraph, graphFileName, getIntOption("candidates", 10));
+    };
+    int numStarts = 1;
+    if (hasOption("starts"))
+    {
+        numStarts = (*findOption("starts") == "all") ? myGraph->numNodes : max(1, min(getIntOption("starts", 1), myGraph->numNodes));
+    };
+    long long totalWeight;
+    if (numStarts == 1)
+    {
+        vector<uint64_t> visited;
+        totalWeight = nearestNeighborTour(myGraph, candidates, 0, path, visited);
+    }
+    else
+    {
+        progress() << "Trying " << numStarts << " start nodes" << '\n';
+        totalWeight = multiStartNearestNeighbor(myGraph, candidates, numStarts, path);
+        progress() << "Best start node: " << path.at(0) << '\n';
+    };
+    delete candidates;
+    return totalWeight;
+};
+
+// Solves a loaded graph exactly with Held-Karp and writes the shortest tour into path. Returns its total distance, or -1 (with a message) if the table does not fit in memory.
+long long heldKarpTour(const graph *myGraph, vector<int> &path)
+{
+    scopedTimer timer("held-karp");
+    // Store the table's costs in the narrowest type that can hold any path through the graph.
+    long long maxWeight = 0;
+    for (int i = 0; i < myGraph->numNodes; i++)
+    {
+        for (int j = 0; j < i; j++)
+        {
+            maxWeight = max(maxWeight, (long long)myGraph->distance(i, j));
+        };
+    };
+    long long pathBound = maxWeight * myGraph->numNodes;
+    int costWidth = (pathBound < heldKarpUnreached<uint16_t>) ? 2 : (pathBound < heldKarpUnreached<uint32_t>) ? 4 : 8;
+
+    // Size the table up front and refuse graphs it would not fit for: --memory-limit=MB, or the machine's physical memory.
+    uint64_t memoryLimit = getMemoryLimit();
+    uint64_t memoryNeeded = heldKarpMemory(myGraph->numNodes, costWidth);
+    if ((memoryNeeded == 0) || (memoryNeeded > memoryLimit))
+    {
+        cerr << "A graph with " << myGraph->numNodes << " nodes needs " << ((memoryNeeded == 0) ? string("more than 2^64 bytes") : to_string(memoryNeeded / (1024 * 1024)) + " MB") << " for Held-Karp, but only " << memoryLimit / (1024 * 1024) << " MB are allowed" << endl;
+        return -1;
+    };
+    progress() << "Held-Karp table: " << memoryNeeded / (1024 * 1024) << " MB (" << costWidth << "-byte costs)" << '\n';
+    try
+    {
+        return (costWidth == 2) ? heldKarp<uint16_t>(myGraph, path) : (costWidth == 4) ? heldKarp<uint32_t>(myGraph, path) : heldKarp<uint64_t>(myGraph, path);
+    }
+    catch (const bad_alloc &)
+    {
+        cerr << "Failed to allocate the Held-Karp table" << endl;
+        return -1;
+    };
+};
+
+// Solves a loaded graph exactly by branch and bound and writes the shortest tour into path. Returns its total distance, or -1 (with a message) if the graph is too large. Checkpoints of the starting tour are named by solPrefix.
+long long branchAndBoundTour(graph *myGraph, const string &graphFileName, vector<int> &path, const string &solPrefix)
+{
+    scopedTimer timer("branch and bound");
+    if (myGraph->numNodes > branchAndBound::maxNodes)
+    {
+        cerr << "Branch and bound handles graphs of up to " << branchAndBound::maxNodes << " nodes" << endl;
+        return -1;
+    };
+
+    // Start from a good tour, so that most of the search is pruned straight away: nearest neighbor from every node, then the improvement stage.
+    long long shortestDistance = multiStartNearestNeighbor(myGraph, nullptr, myGraph->numNodes, path);
+    if (myGraph->numNodes >= 5)
+    {
+        shortestDistance = improveTour(myGraph, graphFileName, path, solPrefix);
+    };
+    progress() << "Starting tour: " << shortestDistance << '\n';
+    branchAndBound search(myGraph, path, shortestDistance);
+    return search.solve(path);
+};
+
+// Returns the start of the .sol file names a solver mode writes ("S" for the original algorithm, "S[MODE]" for the others), or an empty string if there is no such solver mode.
+string solutionPrefix(const string &mode)
+{
+    if (mode == "original")
+    {
+        return "S";
+    };
+    if ((mode == "nearest") || (mode == "brute") || (mode == "heldkarp") || (mode == "bnb"))
+    {
+        string upperMode = mode;
+        transform(upperMode.begin(), upperMode.end(), upperMode.begin(), ::toupper);
+        return "S[" + upperMode + "]";
+    };
+    return "";
+};
+
+// Runs a solver mode (original, nearest, brute, heldkarp or bnb) on a loaded graph, followed by the improvement stage for original and nearest with --improve. Writes the path into path and returns the total distance, or -1 (with a message) on failure.
+// solPrefix starts the names of the checkpoint files the improvement stage writes, so it should match the name the caller gives the final .sol file.
+long long solveGraph(const string &mode, graph *myGraph, const string &graphFileName, vector<int> &path, const string &solPrefix)
+{
+    long long totalWeight = -1;
+    if (mode == "original")
+    {
+        totalWeight = originalTour(myGraph, path);
+    }
+    else if (mode == "nearest")
+    {
+        totalWeight = nearestTour(myGraph, graphFileName, path);
+    }
+    else if (mode == "brute")
+    {
+        return bruteForce(myGraph, path);
+    }
+    else if (mode == "heldkarp")
+    {
+        return heldKarpTour(myGraph, path);
+    }
+    else if (mode == "bnb")
+    {
+        return branchAndBoundTour(myGraph, graphFileName, path, solPrefix);
+    }
+    else
+    {
+        cerr << "Unknown solver mode " << mode << endl;
+        return -1;
+    };
+    if ((totalWeight >= 0) && hasOption("improve"))
+    {
+        totalWeight = improveTour(myGraph, graphFileName, path, solPrefix);
+    };
+    return totalWeight;
+};
+
+// Reads a path from a .sol file into path, dropping the repeated starting node at the end. Returns false (with a message) unless it visits every node of the graph exactly once.
+bool readPathFile(const char *fileName, int numNodes, vector<int> &path)
+{
+    ifstream pathFile(fileName);
+    if (!pathFile.is_open())
+    {
+        cerr << "File cannot be opened" << endl;
+        return false;
+    };
+    path.clear();
+    int pathValue;
+    while (pathFile >> pathValue)
+    {
+        path.push_back(pathValue);
+    };
+    if ((path.size() == numNodes + 1) && (path.front() == path.back()))
+    {
+        path.pop_back();
+    };
+    vector<char> seen(numNodes, 0);
+    for (int i = 0; i < path.size(); i++)
+    {
+        if ((path[i] < 0) || (path[i] >= numNodes) || seen[path[i]])
+        {
+            cerr << "The path in " << fileName << " does not visit every node exactly once" << endl;
+            return false;
+        };
+        seen[path[i]] = 1;
+    };
+    if (path.size() != numNodes)
+    {
+        cerr << "The path in " << fileName << " does not visit every node exactly once" << endl;
+        return false;
+    };
+    return true;
+};
+
+// One line of a batch manifest and what came of it.
+struct batchJob
+{
+    string graphFileName;
+    string mode;
+    string optionText;          // The options as written in the manifest.
+    map<string, string> options;
+    uint64_t memoryEstimate;
+    graph *myGraph;
+    double loadSeconds;
+    double solveSeconds;
+    int numNodes;
+    long long totalWeight;
+    string solutionFile;
+    string status;
+};
+
+// Reads a batch manifest: one job per line, written "graphFile mode [--name=value ...]". Blank lines and lines starting with # are skipped. Returns false (with a message) if the file cannot be read or a line has no mode.
+bool readManifest(const char *fileName, vector<batchJob> &jobs)
+{
+    ifstream manifestFile(fileName);
+    if (!manifestFile.is_open())
+    {
+        cerr << "File cannot be opened" << endl;
+        return false;
+    };
+    string line;
+    for (int lineNumber = 1; getline(manifestFile, line); lineNumber++)
+    {
+        istringstream lineStream(line);
+        batchJob job;
+        if (!(lineStream >> job.graphFileName) || (job.graphFileName[0] == '#'))
+        {
+            continue;
+        };
+        if (!(lineStream >> job.mode))
+        {
+            cerr << "Line " << lineNumber << " of " << fileName << " has no mode" << endl;
+            return false;
+        };
+        string option;
+        while (lineStream >> option)
+        {
+            if (option.compare(0, 2, "--") != 0)
+            {
+                cerr << "Line " << lineNumber << " of " << fileName << " has an argument that is not an --option: " << option << endl;
+                return false;
+            };
+            size_t equals = option.find('=');
+            job.options[option.substr(2, (equals == string::npos) ? string::npos : equals - 2)] = (equals == string::npos) ? "" : option.substr(equals + 1);
+            job.optionText += (job.optionText.empty() ? "" : " ") + option;
+        };
+        job.memoryEstimate = 0;
+        job.myGraph = nullptr;
+        job.loadSeconds = 0;
+        job.solveSeconds = 0;
+        job.numNodes = 0;
+        job.totalWeight = -1;
+        jobs.push_back(job);
+    };
+    return true;
+};
+
+// Returns roughly how much memory loading a graph file takes: a binary file is mapped as it is, and a text file holds at most one weight for every two bytes, each stored in at most four bytes.
+uint64_t graphMemoryEstimate(const string &fileName)
+{
+    struct stat fileInfo;
+    if (stat(fileName.c_str(), &fileInfo) != 0)
+    {
+        return 0;
+    };
+    char magic[sizeof(binaryGraphMagic)] = {};
+    ifstream graphFile(fileName, ios::binary);
+    graphFile.read(magic, sizeof(magic));
+    bool binary = (memcmp(magic, binaryGraphMagic, sizeof(binaryGraphMagic)) == 0);
+    return binary ? fileInfo.st_size : 2 * (uint64_t)fileInfo.st_size;
+};
+
+// Returns a file name without its directory and extension.
+string fileStem(const string &fileName)
+{
+    size_t slash = fileName.find_last_of('/');
+    string name = (slash == string::npos) ? fileName : fileName.substr(slash + 1);
+    size_t dot = name.find_last_of('.');
+    return ((dot == string::npos) || (dot == 0)) ? name : name.substr(0, dot);
+};
+
+// Returns a string as a quoted CSV field, with its quotes doubled, so that commas in file names and options do not split it.
+string csvString(const string &text)
+{
+    string quoted = "\"";
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        quoted += text[i];
+        if (text[i] == '"')
+        {
+            quoted += '"';
+        };
+    };
+    return quoted + "\"";
+};
+
+// Runs every job of a batch manifest in one process and writes a summary. Returns 0, or 1 if the manifest or the summary cannot be used.
+// One loader thread reads the graphs in manifest order, so the next graph is parsed while earlier ones are being solved, and --jobs=J solver threads (one per worker thread by default) take them as they become ready. A graph is only loaded once the estimated memory of the graphs in flight leaves room for it under --memory-limit=MB (a graph on its own is always allowed).
+// Each job gets an equal share of the worker threads and runs quietly, with its own options on top of the command line's. Every job writes its usual .sol file, prefixed with the graph file's name so that jobs on different graphs cannot overwrite each other's, and one line of the summary file (--summary=FILE, batch_summary.csv by default) in manifest order.
+int runBatch(const char *manifestName)
+{
+    vector<batchJob> jobs;
+    if (!readManifest(manifestName, jobs))
+    {
+        return 1;
+    };
+    int numSolvers = max(1, min(getIntOption("jobs", globalThreadCount), (int)max((size_t)1, jobs.size())));
+    int threadsPerJob = max(1, globalThreadCount / numSolvers);
+    uint64_t memoryLimit = getMemoryLimit();
+    progress() << "Running " << jobs.size() << " jobs, " << numSolvers << " at a time with " << threadsPerJob << " threads each" << '\n';
+
+    mutex lock;
+    condition_variable changed;
+    uint64_t memoryInFlight = 0;
+    deque<size_t> ready;
+    bool loaderDone = false;
+    auto releaseMemory = [&](batchJob &job)
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            memoryInFlight -= job.memoryEstimate;
+        };
+        changed.notify_all();
+    };
+
+    thread loader([&]()
+                  {
+        globalJobThreads = threadsPerJob;
+        globalQuietThread = true;
+        for (size_t j = 0; j < jobs.size(); j++)
+        {
+            batchJob &job = jobs[j];
+            if (solutionPrefix(job.mode).empty())
+            {
+                job.status = "unknown mode";
+                continue;
+            };
+
+            // Wait for room, then load.
+            job.memoryEstimate = graphMemoryEstimate(job.graphFileName);
+            {
+                unique_lock<mutex> guard(lock);
+                changed.wait(guard, [&]()
+                             { return (memoryInFlight == 0) || (memoryInFlight + job.memoryEstimate <= memoryLimit); });
+                memoryInFlight += job.memoryEstimate;
+            };
+            globalJobOptions = &job.options;
+            auto loadStart = chrono::steady_clock::now();
+            job.myGraph = new graph();
+            bool loaded = loadGraph(job.graphFileName.c_str(), job.myGraph);
+            job.loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - loadStart).count();
+            globalJobOptions = nullptr;
+            if (!loaded)
+            {
+                job.status = "load failed";
+                delete job.myGraph;
+                job.myGraph = nullptr;
+                releaseMemory(job);
+                continue;
+            };
+            job.numNodes = job.myGraph->numNodes;
+            {
+                lock_guard<mutex> guard(lock);
+                ready.push_back(j);
+            };
+            changed.notify_all();
+        };
+        {
+            lock_guard<mutex> guard(lock);
+            loaderDone = true;
+        };
+        changed.notify_all(); });
+
+    vector<thread> solvers;
+    for (int s = 0; s < numSolvers; s++)
+    {
+        solvers.emplace_back([&]()
+                             {
+            globalJobThreads = threadsPerJob;
+            globalQuietThread = true;
+            while (true)
+            {
+                size_t j;
+                {
+                    unique_lock<mutex> guard(lock);
+                    changed.wait(guard, [&]()
+                                 { return !ready.empty() || loaderDone; });
+                    if (ready.empty())
+                    {
+                        return;
+                    };
+                    j = ready.front();
+                    ready.pop_front();
+                };
+                batchJob &job = jobs[j];
+                globalJobOptions = &job.options;
+                auto solveStart = chrono::steady_clock::now();
+                vector<int> path;
+                string solPrefix = fileStem(job.graphFileName) + "_" + solutionPrefix(job.mode);
+                job.totalWeight = solveGraph(job.mode, job.myGraph, job.graphFileName, path, solPrefix);
+                job.solveSeconds = chrono::duration<double>(chrono::steady_clock::now() - solveStart).count();
+                if (job.totalWeight < 0)
+                {
+                    job.status = "solve failed";
+                }
+                else
+                {
+                    job.solutionFile = solPrefix + to_string(job.totalWeight) + "_wcjunkins.sol";
+                    job.status = writePathFile(job.solutionFile, path) ? "ok" : "write failed";
+                };
+                globalJobOptions = nullptr;
+                delete job.myGraph;
+                job.myGraph = nullptr;
+                releaseMemory(job);
+            }; });
+    };
+    loader.join();
+    for (int s = 0; s < numSolvers; s++)
+    {
+        solvers.at(s).join();
+    };
+
+    // Write the summary, one line per job in manifest order.
+    string summaryName = hasOption("summary") ? *findOption("summary") : "batch_summary.csv";
+    ofstream summaryFile(summaryName);
+    if (!summaryFile.is_open())
+    {
+        cerr << "Failed to open the file for writing" << endl;
+        return 1;
+    };
+    summaryFile << "graph,mode,options,nodes,distance,load_seconds,solve_seconds,solution_file,status\n";
+    int numSolved = 0;
+    for (size_t j = 0; j < jobs.size(); j++)
+    {
+        const batchJob &job = jobs[j];
+        summaryFile << csvString(job.graphFileName) << "," << job.mode << "," << csvString(job.optionText) << "," << job.numNodes << "," << job.totalWeight << "," << job.loadSeconds << "," << job.solveSeconds << "," << csvString(job.solutionFile) << "," << job.status << "\n";
+        numSolved += (job.status == "ok");
+    };
+    summaryFile.close();
+    progress() << "Solved " << numSolved << " of " << jobs.size() << " jobs" << '\n'
+         << "The summary has been saved to the file " << summaryName << '\n';
+    return 0;
+};
+
+// Returns a string as a JSON string literal.
+string jsonString(const string &text)
+{
+    string quoted = "\"";
+    for (int i = 0; i < text.size(); i++)
+    {
+        unsigned char c = text[i];
+        if ((c == '"') || (c == '\\'))
+        {
+            quoted += '\\';
+            quoted += c;
+        }
+        else if (c < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            quoted += escaped;
+        }
+        else
+        {
+            quoted += c;
+        };
+    };
+    return quoted + "\"";
+};
+
+// Writes what the instrumentation gathered when the program ends. --stats prints one JSON object with every phase (how often it ran and its total seconds, summed over threads) and every counter, or writes it to the file given as --stats=FILE. --trace=FILE writes the phases as a Chrome trace (chrome://tracing or Perfetto), one row per thread, with the counters at the end.
+void writeInstrumentation()
+{
+    if (!globalStatsEnabled)
+    {
+        return;
+    };
+    lock_guard<mutex> guard(globalTraceLock);
+    if (hasOption("stats"))
+    {
+        // Add up the phases by name, in the order they first finished.
+        vector<string> names;
+        map<string, pair<uint64_t, double>> totals;
+        for (size_t i = 0; i < globalTraceEvents.size(); i++)
+        {
+            const traceEvent &event = globalTraceEvents[i];
+            if (totals.find(event.name) == totals.end())
+            {
+                names.push_back(event.name);
+            };
+            totals[event.name].first++;
+            totals[event.name].second += event.duration / 1e6;
+        };
+        ostringstream stats;
+        stats << "{\"phases\": {";
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            stats << (i == 0 ? "" : ", ") << jsonString(names[i]) << ": {\"calls\": " << totals[names[i]].first << ", \"seconds\": " << totals[names[i]].second << "}";
+        };
+        stats << "}, \"counters\": {";
+        for (int c = 0; c < numStatCounters; c++)
+        {
+            stats << (c == 0 ? "" : ", ") << jsonString(statCounterNames[c]) << ": " << globalStatCounters[c].load();
+        };
+        stats << "}}\n";
+        string text = stats.str();
+        const string &statsName = *findOption("stats");
+        if (statsName.empty())
+        {
+            cout.write(text.data(), text.size());
+            cout.flush();
+        }
+        else
+        {
+            ofstream statsFile(statsName);
+            statsFile << text;
+            if (!statsFile)
+            {
+                cerr << "Failed to write the stats to " << statsName << endl;
+            };
+        };
+    };
+    if (hasOption("trace"))
+    {
+        const string &traceName = *findOption("trace");
+        ofstream traceFile(traceName);
+        traceFile << "{\"traceEvents\": [\n";
+        double end = chrono::duration<double, micro>(chrono::steady_clock::now() - globalStartTime).count();
+        for (size_t i = 0; i < globalTraceEvents.size(); i++)
+        {
+            const traceEvent &event = globalTraceEvents[i];
+            traceFile << "{\"name\": " << jsonString(event.name) << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << event.thread << ", \"ts\": " << fixed << setprecision(3) << event.start << ", \"dur\": " << event.duration << "},\n";
+        };
+        traceFile << "{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"ts\": " << end << ", \"args\": {";
+        for (int c = 0; c < numStatCounters; c++)
+        {
+            traceFile << (c == 0 ? "" : ", ") << jsonString(statCounterNames[c]) << ": " << globalStatCounters[c].load();
+        };
+        traceFile << "}}\n]}\n";
+        if (!traceFile)
+        {
+            cerr << "Failed to write the trace to " << traceName << endl;
+        };
+    };
+};
+
+// Prints the result of a mode for --quiet and --json: the node count, the total distance, the time spent loading and solving, the .sol file and the tour (path, closed back to its first node). --json prints it as one JSON object. The text is built in memory and written with a single write. Does nothing otherwise, since the usual messages already said it all.
+void printSummary(const string &mode, int numNodes, long long totalWeight, const vector<int> &path, const string &fileName)
+{
+    bool json = hasOption("json");
+    if (!json && !hasOption("quiet"))
+    {
+        return;
+    };
+    auto now = chrono::steady_clock::now();
+    double loadSeconds = chrono::duration<double>(globalLoadedTime - globalStartTime).count();
+    double solveSeconds = chrono::duration<double>(now - globalLoadedTime).count();
+    ostringstream summary;
+    if (json)
+    {
+        summary << "{\"mode\": " << jsonString(mode) << ", \"nodes\": " << numNodes << ", \"distance\": " << totalWeight;
+        if (!globalLoadOverlapped)
+        {
+            summary << ", \"load_seconds\": " << loadSeconds;
+        };
+        summary << ", \"solve_seconds\": " << solveSeconds << ", \"solution_file\": " << jsonString(fileName) << ", \"tour\": [";
+        for (int i = 0; i < path.size(); i++)
+        {
+            summary << path[i] << ", ";
+        };
+        summary << (path.empty() ? "" : to_string(path[0])) << "]}\n";
+    }
+    else
+    {
+        summary << "Mode: " << mode << "\n"
+                << "Nodes: " << numNodes << "\n"
+                << "Total Distance: " << totalWeight << "\n";
+        if (!globalLoadOverlapped)
+        {
+            summary << "Load seconds: " << loadSeconds << "\n";
+        };
+        summary << "Solve seconds: " << solveSeconds << "\n";
+        if (!fileName.empty())
+        {
+            summary << "Solution file: " << fileName << "\n";
+        };
+        summary << "Tour:";
+        for (int i = 0; i < path.size(); i++)
+        {
+            summary << " " << path[i];
+        };
+        summary << (path.empty() ? "" : " " + to_string(path[0])) << "\n";
+    };
+    string text = summary.str();
+    cout.write(text.data(), text.size());
+    cout.flush();
+};
+
+// What checking one .sol file found.
+struct tourCheck
+{
+    string fileName;
+    long long totalWeight; // The distance of the path as written, or -1 if it leaves the graph.
+    size_t length;         // The number of nodes in the file, including the closing one.
+    string status;         // "ok", or the first problem found.
+};
+
+// Checks the path in a .sol file against a graph and writes it into path. A valid tour lists every node exactly once and then returns to its first node, like the files every mode writes.
+// The file is memory-mapped and parsed by hand, visited nodes are marked in a bitset, and the distance is added up in two loops: one gathers the hop distances into a buffer and the other sums it, so the sum vectorizes.
+tourCheck checkTourFile(const graph *myGraph, const string &fileName, vector<int> &path)
+{
+    tourCheck result = {fileName, -1, 0, "ok"};
+    mappedFile file;
+    if (!file.open(fileName.c_str()))
+    {
+        result.status = "unreadable";
+        return result;
+    };
+    path.clear();
+    const char *cursor = file.data;
+    const char *fileEnd = file.data + file.size;
+    while (cursor < fileEnd)
+    {
+        if ((*cursor == ' ') || (*cursor == '\t') || (*cursor == '\r') || (*cursor == '\n'))
+        {
+            cursor++;
+            continue;
+        };
+        uint64_t value = 0;
+        const char *valueStart = cursor;
+        while ((cursor < fileEnd) && (*cursor >= '0') && (*cursor <= '9') && (value <= INT_MAX))
+        {
+            value = value * 10 + (*cursor - '0');
+            cursor++;
+        };
+        if ((cursor == valueStart) || ((cursor < fileEnd) && (*cursor != ' ') && (*cursor != '\t') && (*cursor != '\r') && (*cursor != '\n')))
+        {
+            result.status = "malformed";
+            return result;
+        };
+        if (value >= (uint64_t)myGraph->numNodes)
+        {
+            result.status = "bad node " + string(valueStart, cursor);
+            return result;
+        };
+        path.push_back(value);
+    };
+    result.length = path.size();
+    if (path.empty())
+    {
+        result.status = "empty";
+        return result;
+    };
+
+    // Add up the hops as written.
+    vector<uint32_t> hops(path.size() - 1);
+    for (size_t i = 0; i + 1 < path.size(); i++)
+    {
+        hops[i] = (path[i] == path[i + 1]) ? 0 : myGraph->distance(path[i], path[i + 1]);
+    };
+    long long totalWeight = 0;
+    for (size_t i = 0; i < hops.size(); i++)
+    {
+        totalWeight += hops[i];
+    };
+    result.totalWeight = totalWeight;
+
+    // Every node but the closing one must be new, and all of them must be there.
+    bool closed = (path.size() >= 2) && (path.front() == path.back());
+    size_t numVisits = closed ? path.size() - 1 : path.size();
+    vector<uint64_t> visited((myGraph->numNodes + 63) / 64, 0);
+    for (size_t i = 0; i < numVisits; i++)
+    {
+        uint64_t bit = (uint64_t)1 << (path[i] & 63);
+        if (visited[path[i] >> 6] & bit)
+        {
+            result.status = "repeats " + to_string(path[i]);
+            return result;
+        };
+        visited[path[i] >> 6] |= bit;
+    };
+    if (numVisits < (size_t)myGraph->numNodes)
+    {
+        size_t numMissing = myGraph->numNodes - numVisits;
+        result.status = "misses " + to_string(numMissing) + ((numMissing == 1) ? " node" : " nodes");
+    }
+    else if (!closed)
+    {
+        result.status = "not closed";
+    };
+    return result;
+};
+
+// Checks one or more .sol files against a loaded graph, in parallel, and prints a table of the results. Returns 0 if every file holds a valid tour, otherwise 1.
+// With one file, the hops are traced (at --verbose=2) and --quiet and --json print the usual summary; with more, --json prints the table as a JSON array.
+int checkTours(const graph *myGraph, const vector<string> &fileNames)
+{
+    vector<tourCheck> results(fileNames.size());
+    vector<int> singlePath;
+    parallelTasks(fileNames.size(), [&](int /*worker*/, size_t task)
+                  {
+        vector<int> path;
+        results[task] = checkTourFile(myGraph, fileNames[task], path);
+        if (fileNames.size() == 1)
+        {
+            singlePath.swap(path);
+        }; });
+    int numValid = 0;
+    for (size_t f = 0; f < results.size(); f++)
+    {
+        numValid += (results[f].status == "ok");
+    };
+
+    if (fileNames.size() == 1)
+    {
+        for (size_t i = 0; (globalVerbosity >= 2) && (results[0].totalWeight >= 0) && (i + 1 < singlePath.size()); i++)
+        {
+            int hopWeight = (singlePath[i] == singlePath[i + 1]) ? 0 : myGraph->distance(singlePath[i], singlePath[i + 1]);
+            progress(2) << singlePath[i] << "---" << hopWeight << "-->" << singlePath[i + 1] << '\n';
+        };
+        progress() << "Total path distance: " << results[0].totalWeight << '\n';
+        if (results[0].status != "ok")
+        {
+            cerr << "The path in " << fileNames[0] << " is not a tour: " << results[0].status << endl;
+        };
+        if ((singlePath.size() > 1) && (singlePath.front() == singlePath.back()))
+        {
+            singlePath.pop_back();
+        };
+        printSummary("check", myGraph->numNodes, results[0].totalWeight, singlePath, "");
+        return (numValid == 1) ? 0 : 1;
+    };
+
+    // One line per file, written at once.
+    ostringstream table;
+    if (hasOption("json"))
+    {
+        table << "[";
+        for (size_t f = 0; f < results.size(); f++)
+        {
+            table << (f == 0 ? "" : ",") << "\n{\"file\": " << jsonString(results[f].fileName) << ", \"nodes\": " << results[f].length << ", \"distance\": " << results[f].totalWeight << ", \"status\": " << jsonString(results[f].status) << "}";
+        };
+        table << "\n]\n";
+    }
+    else
+    {
+        size_t statusWidth = 8;
+        for (size_t f = 0; f < results.size(); f++)
+        {
+            statusWidth = max(statusWidth, results[f].status.size() + 2);
+        };
+        table << left << setw(14) << "distance" << setw(statusWidth) << "status" << "file" << '\n';
+        for (size_t f = 0; f < results.size(); f++)
+        {
+            table << left << setw(14) << results[f].totalWeight << setw(statusWidth) << results[f].status << results[f].fileName << '\n';
+        };
+        table << numValid << " of " << results.size() << " files hold valid tours" << '\n';
+    };
+    string text = table.str();
+    cout.write(text.data(), text.size());
+    cout.flush();
+    return (numValid == (int)results.size()) ? 0 : 1;
+};
+
+// Splits a comma-separated list, such as the value of --sizes, into its items. Empty items are dropped.
+vector<string> splitList(const string &text)
+{
+    vector<string> items;
+    stringstream listStream(text);
+    string item;
+    while (getline(listStream, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        };
+    };
+    return items;
+};
+
+// What one benchmark run sends back from the process that ran it.
+struct benchResult
+{
+    long long cost;        // The tour's total distance, or -1 if the solver failed.
+    double solveSeconds;   // Time spent building the tour.
+    double improveSeconds; // Time spent in the improvement stage (0 without it).
+};
+
+// Runs a solver mode (and the improvement stage after it, if asked) on a generated graph in a child process, so that every run starts from the same state and its peak memory can be measured on its own. Returns false (with a message) if the run failed; otherwise fills result and peakKilobytes, the run's peak resident set size.
+bool benchRun(graph *myGraph, const string &mode, bool improve, benchResult &result, long &peakKilobytes)
+{
+    int fds[2];
+    if (pipe(fds) != 0)
+    {
+        cerr << "Failed to create a pipe for the benchmark run" << endl;
+        return false;
+    };
+    cout.flush();
+    pid_t child = fork();
+    if (child < 0)
+    {
+        cerr << "Failed to start the benchmark run" << endl;
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    };
+    if (child == 0)
+    {
+        // In the child: solve quietly, report through the pipe and leave without running any destructors.
+        close(fds[0]);
+        globalVerbosity = 0;
+        benchResult childResult = {-1, 0, 0};
+        vector<int> path;
+        auto solveStart = chrono::steady_clock::now();
+        childResult.cost = solveGraph(mode, myGraph, "", path, solutionPrefix(mode));
+        auto improveStart = chrono::steady_clock::now();
+        childResult.solveSeconds = chrono::duration<double>(improveStart - solveStart).count();
+        if (improve && (childResult.cost >= 0))
+        {
+            childResult.cost = improveTour(myGraph, "", path, solutionPrefix(mode));
+            childResult.improveSeconds = chrono::duration<double>(chrono::steady_clock::now() - improveStart).count();
+        };
+        bool sent = (write(fds[1], &childResult, sizeof(childResult)) == (ssize_t)sizeof(childResult));
+        _exit(sent ? 0 : 1);
+    };
+
+    close(fds[1]);
+    size_t received = 0;
+    while (received < sizeof(result))
+    {
+        ssize_t count = read(fds[0], (char *)&result + received, sizeof(result) - received);
+        if (count <= 0)
+        {
+            break;
+        };
+        received += count;
+    };
+    close(fds[0]);
+    int status;
+    struct rusage usage;
+    if (wait4(child, &status, 0, &usage) != child)
+    {
+        cerr << "Lost track of the benchmark run" << endl;
+        return false;
+    };
+    peakKilobytes = usage.ru_maxrss;
+    return (received == sizeof(result)) && WIFEXITED(status) && (WEXITSTATUS(status) == 0) && (result.cost >= 0);
+};
+
+// Returns whether an exact solver mode finishes on a graph of the given size in bench mode. brute runs up to --brute-max=N nodes (12 by default); heldkarp and bnb up to the sizes they accept.
+bool benchFits(const string &mode, int numNodes)
+{
+    if (mode == "brute")
+    {
+        return numNodes <= getIntOption("brute-max", 12);
+    };
+    if (mode == "heldkarp")
+    {
+        uint64_t memoryNeeded = heldKarpMemory(numNodes, 4);
+        return (memoryNeeded != 0) && (memoryNeeded <= getMemoryLimit());
+    };
+    if (mode == "bnb")
+    {
+        return numNodes <= branchAndBound::maxNodes;
+    };
+    return true;
+};
+
+// Benchmarks the solver modes on generated graphs and writes a report. Returns 0, or 1 if the options or the report file cannot be used.
+// Every combination of --families=F,... (uniform, euclidean and clustered by default), --sizes=N,... (10 to 50000 by default) and --modes=M,... (original, nearest, brute, original+improve and nearest+improve by default; "+improve" adds the improvement stage) is run --runs=R times (3 by default) on the graph that --seed=S (1 by default) gives. Exact modes are skipped on graphs too large for them, and so are graphs that do not fit in --memory-limit=MB.
+// Each run happens in a child process. The report (--report=FILE, bench_report.csv by default, or JSON if the name ends in .json) has one row per run: the time to generate the graph, build the tour and improve it, the peak resident set size, the tour's distance, and its ratio to the best distance any run found on the same graph (which is optimal if an exact mode ran). The same options give the same graphs and distances, so reports of two builds can be diffed.
+int runBench()
+{
+    vector<string> families = splitList(hasOption("families") ? *findOption("families") : "uniform,euclidean,clustered");
+    vector<string> sizeNames = splitList(hasOption("sizes") ? *findOption("sizes") : "10,100,1000,10000,50000");
+    vector<string> modes = splitList(hasOption("modes") ? *findOption("modes") : "original,nearest,brute,original+improve,nearest+improve");
+    int numRuns = max(1, getIntOption("runs", 3));
+    uint64_t seed = getIntOption("seed", 1);
+    vector<int> sizes;
+    for (size_t i = 0; i < sizeNames.size(); i++)
+    {
+        int size = atoi(sizeNames[i].c_str());
+        if (size < 1)
+        {
+            cerr << "Bad benchmark size " << sizeNames[i] << endl;
+            return 1;
+        };
+        sizes.push_back(size);
+    };
+    for (size_t f = 0; f < families.size(); f++)
+    {
+        if ((families[f] != "uniform") && (families[f] != "euclidean") && (families[f] != "clustered"))
+        {
+            cerr << "Unknown graph family " << families[f] << " (use uniform, euclidean or clustered)" << endl;
+            return 1;
+        };
+    };
+    for (size_t m = 0; m < modes.size(); m++)
+    {
+        string baseMode = modes[m].substr(0, modes[m].find('+'));
+        if (solutionPrefix(baseMode).empty() || ((baseMode != modes[m]) && (modes[m] != baseMode + "+improve")))
+        {
+            cerr << "Unknown benchmark mode " << modes[m] << endl;
+            return 1;
+        };
+    };
+
+    string reportName = hasOption("report") ? *findOption("report") : "bench_report.csv";
+    bool json = (reportName.size() >= 5) && (reportName.compare(reportName.size() - 5, 5, ".json") == 0);
+    ofstream reportFile(reportName);
+    if (!reportFile.is_open())
+    {
+        cerr << "Failed to open the file for writing" << endl;
+        return 1;
+    };
+    reportFile << (json ? "[\n" : "family,nodes,seed,mode,run,generate_seconds,solve_seconds,improve_seconds,total_seconds,peak_rss_kb,distance,best_distance,ratio,best_is_optimal,status\n");
+    bool firstRow = true;
+    uint64_t memoryLimit = getMemoryLimit();
+    for (size_t f = 0; f < families.size(); f++)
+    {
+        for (size_t n = 0; n < sizes.size(); n++)
+        {
+            const string &family = families[f];
+            int numNodes = sizes[n];
+            uint64_t memoryNeeded = (family == "uniform") ? graph::triangleSize(numNodes) * sizeof(uint16_t) : (uint64_t)numNodes * 2 * sizeof(double);
+            if (memoryNeeded > memoryLimit)
+            {
+                progress() << "Skipping " << family << " " << numNodes << ": it needs " << memoryNeeded / (1024 * 1024) << " MB" << '\n';
+                continue;
+            };
+            auto generateStart = chrono::steady_clock::now();
+            graph *myGraph = new graph();
+            generateGraph(family, numNodes, seed, myGraph);
+            double generateSeconds = chrono::duration<double>(chrono::steady_clock::now() - generateStart).count();
+
+            // Run everything on this graph first, so that every row can be given its ratio to the best distance.
+            vector<string> rowModes;
+            vector<int> rowRuns;
+            vector<benchResult> results;
+            vector<long> peaks;
+            vector<bool> succeeded;
+            long long bestCost = LLONG_MAX;
+            bool bestIsOptimal = false;
+            for (size_t m = 0; m < modes.size(); m++)
+            {
+                string baseMode = modes[m].substr(0, modes[m].find('+'));
+                if (!benchFits(baseMode, numNodes))
+                {
+                    continue;
+                };
+                bool exact = (baseMode == "brute") || (baseMode == "heldkarp") || (baseMode == "bnb");
+                for (int r = 1; r <= numRuns; r++)
+                {
+                    benchResult result = {-1, 0, 0};
+                    long peakKilobytes = 0;
+                    bool ok = benchRun(myGraph, baseMode, baseMode != modes[m], result, peakKilobytes);
+                    progress() << family << " " << numNodes << " " << modes[m] << " run " << r << ": " << (ok ? to_string(result.cost) : string("failed")) << " in " << result.solveSeconds + result.improveSeconds << " s, " << peakKilobytes / 1024 << " MB" << '\n';
+                    rowModes.push_back(modes[m]);
+                    rowRuns.push_back(r);
+                    results.push_back(result);
+                    peaks.push_back(peakKilobytes);
+                    succeeded.push_back(ok);
+                    if (ok)
+                    {
+                        bestCost = min(bestCost, result.cost);
+                        bestIsOptimal = bestIsOptimal || exact;
+                    };
+                };
+            };
+            delete myGraph;
+
+            for (size_t i = 0; i < results.size(); i++)
+            {
+                const benchResult &result = results[i];
+                double ratio = (succeeded[i] && (bestCost > 0)) ? (double)result.cost / bestCost : (succeeded[i] ? 1.0 : 0.0);
+                long long bestShown = (bestCost == LLONG_MAX) ? -1 : bestCost;
+                if (json)
+                {
+                    reportFile << (firstRow ? "" : ",\n") << "{\"family\": " << jsonString(family) << ", \"nodes\": " << numNodes << ", \"seed\": " << seed << ", \"mode\": " << jsonString(rowModes[i]) << ", \"run\": " << rowRuns[i]
+                               << ", \"generate_seconds\": " << generateSeconds << ", \"solve_seconds\": " << result.solveSeconds << ", \"improve_seconds\": " << result.improveSeconds << ", \"total_seconds\": " << result.solveSeconds + result.improveSeconds
+                               << ", \"peak_rss_kb\": " << peaks[i] << ", \"distance\": " << (succeeded[i] ? result.cost : -1) << ", \"best_distance\": " << bestShown << ", \"ratio\": " << ratio
+                               << ", \"best_is_optimal\": " << (bestIsOptimal ? "true" : "false") << ", \"status\": " << jsonString(succeeded[i] ? "ok" : "failed") << "}";
+                }
+                else
+                {
+                    reportFile << family << "," << numNodes << "," << seed << "," << rowModes[i] << "," << rowRuns[i] << "," << generateSeconds << "," << result.solveSeconds << "," << result.improveSeconds << "," << result.solveSeconds + result.improveSeconds << ","
+                               << peaks[i] << "," << (succeeded[i] ? result.cost : -1) << "," << bestShown << "," << ratio << "," << (bestIsOptimal ? 1 : 0) << "," << (succeeded[i] ? "ok" : "failed") << "\n";
+                };
+                firstRow = false;
+            };
+            reportFile.flush();
+        };
+    };
+    reportFile << (json ? "\n]\n" : "");
+    reportFile.close();
+    if (reportFile.fail())
+    {
+        cerr << "Failed to write the report" << endl;
+        return 1;
+    };
+    progress() << "The benchmark report has been saved to the file " << reportName << '\n';
+    return 0;
+};
+
+// Writes the blocks that formatBlock(b, bytes) produces, in order and back to back from offset `start` of a file. The blocks are formatted in parallel, a round of a few per thread at a time, and every block of a round is then written at its place with pwrite, so the file comes out the same for any number of threads. Returns the offset after the last block, or -1 if a write failed.
+long long writeBlocks(int fileDescriptor, long long start, size_t numBlocks, const function<void(size_t, vector<char> &)> &formatBlock)
+{
+    size_t roundSize = 2 * activeThreadCount();
+    vector<vector<char>> buffers(roundSize);
+    vector<long long> offsets(roundSize + 1);
+    atomic<bool> failed(false);
+    for (size_t first = 0; first < numBlocks; first += roundSize)
+    {
+        size_t count = min(roundSize, numBlocks - first);
+        parallelTasks(count, [&](int /*worker*/, size_t task)
+                      {
+            buffers[task].clear();
+            formatBlock(first + task, buffers[task]); });
+        offsets[0] = start;
+        for (size_t b = 0; b < count; b++)
+        {
+            offsets[b + 1] = offsets[b] + buffers[b].size();
+        };
+        parallelTasks(count, [&](int /*worker*/, size_t task)
+                      {
+            scopedTimer timer("write block");
+            size_t written = 0;
+            while (written < buffers[task].size())
+            {
+                ssize_t result = pwrite(fileDescriptor, buffers[task].data() + written, buffers[task].size() - written, offsets[task] + written);
+                if (result <= 0)
+                {
+                    failed = true;
+                    return;
+                };
+                written += result;
+            }; });
+        if (failed)
+        {
+            return -1;
+        };
+        start = offsets[count];
+    };
+    return start;
+};
+
+// Appends a number and a separator to a text buffer.
+inline void appendNumber(vector<char> &bytes, uint64_t value, char separator)
+{
+    char digits[24];
+    char *end = to_chars(digits, digits + sizeof(digits), value).ptr;
+    *end++ = separator;
+    bytes.insert(bytes.end(), digits, end);
+};
+
+// Writes a generated graph to a file without ever holding its matrix in memory. Returns 0, or 1 (with a message) if the options or the file cannot be used.
+// --family=F picks the graph (uniform, euclidean or clustered, as in bench mode; the point families are written as the rounded distances between the points), --nodes=N its size (1000 by default) and --seed=S the seed (1 by default). The same options always give the same file, whatever the number of threads, and the graph bench mode generates from them.
+// --format=text writes the lower-triangular text format of graphMaker.py, binary the format of convert mode and points the "x y" coordinate file of a point family. By default the format follows the extension: .bgraph is binary, .pts is points and anything else is text.
+// Rows are generated in blocks of about a million weights, each from its own per-row seeds, and written in parallel.
+int runGenerate(const string &fileName)
+{
+    string family = hasOption("family") ? *findOption("family") : "uniform";
+    int numNodes = getIntOption("nodes", 1000);
+    uint64_t seed = getIntOption("seed", 1);
+    bool hasExtension = (fileName.size() > 4) && (fileName.find_last_of('.') != string::npos);
+    string extension = hasExtension ? fileName.substr(fileName.find_last_of('.')) : "";
+    string format = hasOption("format") ? *findOption("format") : (extension == ".bgraph") ? "binary" : (extension == ".pts") ? "points" : "text";
+    if ((family != "uniform") && (family != "euclidean") && (family != "clustered"))
+    {
+        cerr << "Unknown graph family " << family << " (use uniform, euclidean or clustered)" << endl;
+        return 1;
+    };
+    if ((format != "text") && (format != "binary") && (format != "points"))
+    {
+        cerr << "Unknown graph format " << format << " (use text, binary or points)" << endl;
+        return 1;
+    };
+    if ((format == "points") && (family == "uniform"))
+    {
+        cerr << "Uniform graphs have no points to write" << endl;
+        return 1;
+    };
+    if (numNodes < 1)
+    {
+        cerr << "A graph needs at least one node" << endl;
+        return 1;
+    };
+    if (fileName.empty())
     {
-        this->value = value;
-        this->fromNode = fromNode;
-        this->toNode = toNode;
+        cerr << "Give the name of the file to write" << endl;
+        return 1;
     };
-};
-
-class graph
-{
-public:
-    int numNodes;
-
-    // The Adjacency Matrix.
-    vector<vector<int>> matrix;
-
-    // The vector of weights to sort.
-    vector<weight *> weights;
-
-    // The vector of nodes. This will be useful in keeping up with the current state of each node (e.g. which group they are in.).
-    vector<node *> nodes;
-
-    // The vector of node connectioins we make. This will be useful when we need to retrace our path.
-    vector<connectedNode *> connectedNodes;
-
-    // The vector of integers showing what path we took.
-    vector<int> pathTaken;
 
-    // Add a weight value to the weight matrix. Also add it to the weight vector and specify which nodes it connects (which corresponds to the row and column it lies in the matrix).
-    void addWeight(int row, int item)
+    // The point families need only their points (16 bytes each); a row of distances is computed from them when it is written.
+    graph points;
+    if (family != "uniform")
     {
-        if (matrix.size() <= row)
-        {
-            matrix.resize(row + 1); // Resize the matrix to accommodate the new index.
-        };
-        matrix.at(row).push_back(item);
-
-        // Add the weight (item) to the weights vector. If the weight is 0, do not add it, this will mean nothing; this assumes that no weights, other than ones that connect the same node, will be 0. Also specify which nodes the weight is connecting.
-        if (item != 0)
-        {
-            weight *newWeight = new weight(item, row, matrix.at(row).size() - 1);
-            this->weights.push_back(newWeight);
-        };
+        generateGraph(family, numNodes, seed, &points);
     };
+    int weightWidth = (family == "uniform") ? 2 : 4;
 
-    // Prints the weight-matrix that was read-in from the file.
-    void printMatrix()
+    // Split the rows into blocks of about a million weights (point files: a million points).
+    const uint64_t blockValues = 1 << 20;
+    vector<int> blockStarts(1, 0);
+    for (int row = 0, blockRows = 0; row < numNodes; row++)
     {
-        for (int i = 0; i < this->matrix.size(); i++)
+        blockRows++;
+        uint64_t blockSize = (format == "points") ? (uint64_t)blockRows : graph::triangleSize(row + 1) - graph::triangleSize(blockStarts.back());
+        if ((blockSize >= blockValues) || (row == numNodes - 1))
         {
-            for (int j = 0; j < this->matrix.at(i).size(); j++)
-            {
-                cout << this->matrix.at(i).at(j) << "\t";
-            };
-            cout << endl;
+            blockStarts.push_back(row + 1);
+            blockRows = 0;
         };
     };
+    size_t numBlocks = blockStarts.size() - 1;
 
-    // Looks-up the distance from a node to a node.
-    double distance(int from, int to)
+    int fileDescriptor = ::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fileDescriptor < 0)
     {
-        if (from < to)
-        {
-            return this->matrix.at(to).at(from);
-        }
-        return this->matrix.at(from).at(to);
+        cerr << "Failed to open the file for writing" << endl;
+        return 1;
+    };
+    long long start = 0;
+    if (format == "binary")
+    {
+        binaryGraphHeader header;
+        memcpy(header.magic, binaryGraphMagic, sizeof(header.magic));
+        header.version = binaryGraphVersion;
+        header.numNodes = numNodes;
+        header.weightWidth = weightWidth;
+        start = (pwrite(fileDescriptor, &header, sizeof(header), 0) == (ssize_t)sizeof(header)) ? sizeof(header) : -1;
     };
+    if (start >= 0)
+    {
+        scopedTimer timer("generate file");
+        start = writeBlocks(fileDescriptor, start, numBlocks, [&](size_t b, vector<char> &bytes)
+                            {
+            vector<uint32_t> row((format == "points") ? 0 : blockStarts[b + 1]);
+            for (int i = blockStarts[b]; i < blockStarts[b + 1]; i++)
+            {
+                if (format == "points")
+                {
+                    appendNumber(bytes, (uint64_t)points.xCoords[i], ' ');
+                    appendNumber(bytes, (uint64_t)points.yCoords[i], '\n');
+                    continue;
+                };
 
-    // A one-time function that sorts the edge-weights.
-    void sortWeghts()
+                // Only the part of the row before its diagonal is written (and, in text, the diagonal 0).
+                if (family == "uniform")
+                {
+                    uniformRow(seed, i, row.data());
+                }
+                else
+                {
+                    for (int j = 0; j < i; j++)
+                    {
+                        row[j] = points.pointDistance(i, j);
+                    };
+                };
+                if (format == "binary")
+                {
+                    size_t offset = bytes.size();
+                    bytes.resize(offset + (size_t)i * weightWidth);
+                    for (int j = 0; j < i; j++)
+                    {
+                        if (weightWidth == 2)
+                        {
+                            uint16_t value = row[j];
+                            memcpy(&bytes[offset + 2 * (size_t)j], &value, 2);
+                        }
+                        else
+                        {
+                            memcpy(&bytes[offset + 4 * (size_t)j], &row[j], 4);
+                        };
+                    };
+                }
+                else
+                {
+                    for (int j = 0; j < i; j++)
+                    {
+                        appendNumber(bytes, row[j], ' ');
+                    };
+                    appendNumber(bytes, 0, '\n');
+                };
+            }; });
+    };
+    bool closed = (::close(fileDescriptor) == 0);
+    if ((start < 0) || !closed)
     {
-        sort(weights.begin(), weights.end(), [](const weight *a, const weight *b)
-             { return a->value < b->value; });
+        cerr << "Failed to write the graph to " << fileName << endl;
+        return 1;
     };
+    progress() << "Wrote a " << family << " graph of " << numNodes << " nodes (" << start / (1024 * 1024) << " MB) to the file " << fileName << '\n';
+    return 0;
 };
 
 int main(int argc, char *argv[])
 {
-    // Decide what to do.
-    if (strcmp(argv[1], "original") == 0)
+    // Separate the --options from the positional arguments (programMode inputFile.ext pathToCheck.ext).
+    vector<char *> args;
+    for (int i = 0; i < argc; i++)
+    {
+        if (strncmp(argv[i], "--", 2) == 0)
+        {
+            const char *equals = strchr(argv[i], '=');
+            if (equals == nullptr)
+            {
+                globalOptions[argv[i] + 2] = "";
+            }
+            else
+            {
+                globalOptions[string((const char *)argv[i] + 2, equals)] = equals + 1;
+            };
+        }
+        else
+        {
+            args.push_back(argv[i]);
+        };
+    };
+    globalThreadCount = max(1, getIntOption("threads", globalThreadCount));
+    globalVerbosity = (hasOption("quiet") || hasOption("json")) ? 0 : 2;
+    globalVerbosity = getIntOption("verbose", globalVerbosity);
+    globalArgminKernel = pickArgminKernel();
+    globalStatsEnabled = hasOption("stats") || hasOption("trace");
+    atexit(writeInstrumentation);
+
+    // Decide what to do. Missing arguments are treated as empty, which no mode or file name matches.
+    if (args.size() < 3)
+    {
+        args.resize(3, (char *)"");
+    };
+    if (strcmp(args[1], "original") == 0)
     {
-        cout << "Running ORIGINAL algorithm" << endl;
+        progress() << "Running ORIGINAL algorithm" << '\n';
     }
-    else if (strcmp(argv[1], "nearest") == 0)
+    else if (strcmp(args[1], "nearest") == 0)
     {
         // Run nearest neighbor.
         // Read-in the file.
-        cout << "Running NEAREST NEIGHBOR algorithm" << endl;
-        ifstream file(argv[2]);
-        if (!file.is_open())
+        progress() << "Running NEAREST NEIGHBOR algorithm" << '\n';
+        graph *myGraph = new graph();
+        if (!loadGraph(args[2], myGraph))
         {
-            cerr << "Failed to open file" << endl;
             return 1;
         };
-        graph *myGraph = new graph();
-        string textLine;
-        int index = 0;
-        while (getline(file, textLine))
+        globalLoadedTime = chrono::steady_clock::now();
+
+        // Starting with node 0 (or every start node given by --starts), perform nearest neighbor.
+        long long totalWeight = nearestTour(myGraph, args[2], myGraph->pathTaken);
+
+        // Print the path we took, including the way back to the starting node.
+        for (int i = 0; (myGraph->numNodes > 1) && (i < myGraph->numNodes); i++)
         {
-            istringstream iss(textLine);
-            int weightToAdd;
-            while (iss >> weightToAdd)
-            {
-                myGraph->addWeight(index, weightToAdd);
-            };
-            node *newNode = new node(index);
-            myGraph->nodes.push_back(newNode);
-            index++;
+            int fromNode = myGraph->pathTaken.at(i);
+            int toNode = myGraph->pathTaken.at((i + 1) % myGraph->numNodes);
+            progress(2) << fromNode << "---" << myGraph->distance(fromNode, toNode) << "-->" << toNode << '\n';
         };
-        file.close();
-        myGraph->numNodes = index;
-
-        // Starting with node 0, perform nearest neighbor.
-        // Cycle through each node and its connected nodes to find the shortest path. Then move to that node.
-        int currentNodeIndex = 0;
-        int smallestNodeIndex;
-        int totalWeight = 0;
-        int smallestWeight;
-        node *currentNode;
-        currentNode = myGraph->nodes.at(currentNodeIndex);
-        currentNode->wasTouched = true;
-        for (int x = 0; x < myGraph->nodes.size() - 1; x++)
+        if (hasOption("improve"))
         {
-            smallestWeight = INT_MAX;
-            for (int i = 0; i < myGraph->nodes.size(); i++)
-            {
-                if ((currentNodeIndex != i) && (myGraph->nodes.at(i)->wasTouched == false))
-                {
-                    if (myGraph->distance(currentNodeIndex, i) < smallestWeight)
-                    {
-                        smallestWeight = myGraph->distance(currentNodeIndex, i);
-                        smallestNodeIndex = i;
-                    };
-                };
-            };
-            cout << currentNode->nodeName << "---" << myGraph->distance(currentNodeIndex, smallestNodeIndex) << "-->" << myGraph->nodes.at(smallestNodeIndex)->nodeName << endl;
-            myGraph->pathTaken.push_back(currentNodeIndex);
-            totalWeight += smallestWeight;
-            currentNode = myGraph->nodes.at(smallestNodeIndex);
-            currentNodeIndex = smallestNodeIndex;
-            currentNode->wasTouched = true;
+            totalWeight = improveTour(myGraph, args[2], myGraph->pathTaken, "S[NEAREST]");
         };
 
-        // Add the distance from the starting node to the ending node.
-        cout << currentNode->nodeName << "---" << myGraph->distance(currentNodeIndex, 0) << "-->" << myGraph->nodes.at(0)->nodeName << endl;
-        myGraph->pathTaken.push_back(currentNodeIndex);
-        totalWeight += myGraph->distance(currentNodeIndex, 0);
-
         // Write the output to a file
-        cout << "Writing path to file" << endl;
+        progress() << "Writing path to file" << '\n';
         string fileName = "S[NEAREST]" + to_string(totalWeight) + "_wcjunkins.sol";
-        ofstream outFile(fileName);
-        if (!outFile.is_open())
+        if (!writePathFile(fileName, myGraph->pathTaken))
         {
             cerr << "Failed to open the file for writing" << endl;
             return 1;
         };
-        for (int i = 0; i < myGraph->pathTaken.size(); i++)
-        {
-            outFile << myGraph->pathTaken.at(i) << " ";
-        };
-        outFile << myGraph->pathTaken.at(0) << " ";
-        outFile.close();
 
-        cout << "Total Distance: " << totalWeight << endl;
+        progress() << "Total Distance: " << totalWeight << '\n';
 
-        cout << "The shortest path has been successfully generated" << endl
-             << "A copy of the complete path has been saved to the file " << fileName << endl
-             << "Closing program..." << endl;
+        progress() << "The shortest path has been successfully generated" << '\n'
+             << "A copy of the complete path has been saved to the file " << fileName << '\n'
+             << "Closing program..." << '\n';
+        printSummary("nearest", myGraph->numNodes, totalWeight, myGraph->pathTaken, fileName);
 
         return 0;
     }
-    else if (strcmp(argv[1], "brute") == 0)
+    else if (strcmp(args[1], "brute") == 0)
     {
         // Run brute force. Inspiration was taken from GeeksforGeeks.com.
-        cout << "Running BRUTE FORCE algorithm" << endl;
+        progress() << "Running BRUTE FORCE algorithm" << '\n';
 
         // Read-in the file.
-        ifstream file(argv[2]);
-        if (!file.is_open())
+        graph *myGraph = new graph();
+        if (!loadGraph(args[2], myGraph))
+        {
+            return 1;
+        };
+        globalLoadedTime = chrono::steady_clock::now();
+
+        // Try every order of the nodes after node 0, on all threads.
+        vector<int> pathTaken;
+        long long shortestDistance = bruteForce(myGraph, pathTaken);
+
+        //  Write the output to a file
+        progress() << "Writing path to file" << '\n';
+        string fileName = "S[BRUTE]" + to_string(shortestDistance) + "_wcjunkins.sol";
+        if (!writePathFile(fileName, pathTaken))
         {
-            cerr << "Failed to open file" << endl;
+            cerr << "Failed to open the file for writing" << endl;
             return 1;
         };
+
+        progress() << "Total Distance: " << shortestDistance << '\n';
+
+        progress() << "The shortest path has been successfully generated" << '\n'
+             << "A copy of the complete path has been saved to the file " << fileName << '\n'
+             << "Closing program..." << '\n';
+        printSummary("brute", myGraph->numNodes, shortestDistance, pathTaken, fileName);
+
+        return 0;
+    }
+    else if (strcmp(args[1], "heldkarp") == 0)
+    {
+        // Solve the graph exactly with the Held-Karp dynamic program.
+        progress() << "Running HELD-KARP algorithm" << '\n';
         graph *myGraph = new graph();
-        string textLine;
-        int index = 0;
-        while (getline(file, textLine))
+        if (!loadGraph(args[2], myGraph))
         {
-            istringstream iss(textLine);
-            int weightToAdd;
-            while (iss >> weightToAdd)
-            {
-                myGraph->addWeight(index, weightToAdd);
-            };
-            node *newNode = new node(index);
-            myGraph->nodes.push_back(newNode);
-            index++;
+            return 1;
         };
-        file.close();
-        myGraph->numNodes = index;
+        globalLoadedTime = chrono::steady_clock::now();
 
-        vector<int> nodeIndex(myGraph->numNodes);
-        vector<int> pathTaken(myGraph->numNodes);
-        for (int i = 0; i < myGraph->numNodes; i++)
+        vector<int> pathTaken;
+        long long shortestDistance = heldKarpTour(myGraph, pathTaken);
+        if (shortestDistance < 0)
+        {
+            return 1;
+        };
+
+        //  Write the output to a file
+        progress() << "Writing path to file" << '\n';
+        string fileName = "S[HELDKARP]" + to_string(shortestDistance) + "_wcjunkins.sol";
+        if (!writePathFile(fileName, pathTaken))
         {
-            nodeIndex.at(i) = i;
+            cerr << "Failed to open the file for writing" << endl;
+            return 1;
         };
 
-        int shortestDistance = INT_MAX;
-        do
+        progress() << "Total Distance: " << shortestDistance << '\n';
+
+        progress() << "The shortest path has been successfully generated" << '\n'
+             << "A copy of the complete path has been saved to the file " << fileName << '\n'
+             << "Closing program..." << '\n';
+        printSummary("heldkarp", myGraph->numNodes, shortestDistance, pathTaken, fileName);
+
+        return 0;
+    }
+    else if (strcmp(args[1], "bnb") == 0)
+    {
+        // Solve the graph exactly by branch and bound.
+        progress() << "Running BRANCH AND BOUND algorithm" << '\n';
+        graph *myGraph = new graph();
+        if (!loadGraph(args[2], myGraph))
         {
-            int currentPathDistance = 0;
-            for (int i = 0; i < myGraph->numNodes - 1; i++)
-            {
-                currentPathDistance += myGraph->distance(nodeIndex.at(i), nodeIndex.at(i + 1));
-            };
-            currentPathDistance += myGraph->distance(nodeIndex.back(), nodeIndex.at(0));
-            if (currentPathDistance < shortestDistance)
-            {
-                shortestDistance = currentPathDistance;
-                pathTaken = nodeIndex;
-            }
-        } while (next_permutation(nodeIndex.begin() + 1, nodeIndex.end()));
+            return 1;
+        };
+        globalLoadedTime = chrono::steady_clock::now();
+        vector<int> pathTaken;
+        long long shortestDistance = branchAndBoundTour(myGraph, args[2], pathTaken, "S[BNB]");
+        if (shortestDistance < 0)
+        {
+            return 1;
+        };
 
         //  Write the output to a file
-        cout << "Writing path to file" << endl;
-        string fileName = "S[BRUTE]" + to_string(shortestDistance) + "_wcjunkins.sol";
-        ofstream outFile(fileName);
-        if (!outFile.is_open())
+        progress() << "Writing path to file" << '\n';
+        string fileName = "S[BNB]" + to_string(shortestDistance) + "_wcjunkins.sol";
+        if (!writePathFile(fileName, pathTaken))
         {
             cerr << "Failed to open the file for writing" << endl;
             return 1;
         };
-        for (int i = 0; i < pathTaken.size(); i++)
+
+        progress() << "Total Distance: " << shortestDistance << '\n';
+
+        progress() << "The shortest path has been successfully generated" << '\n'
+             << "A copy of the complete path has been saved to the file " << fileName << '\n'
+             << "Closing program..." << '\n';
+        printSummary("bnb", myGraph->numNodes, shortestDistance, pathTaken, fileName);
+
+        return 0;
+    }
+    else if (strcmp(args[1], "stream") == 0)
+    {
+        // Run the original algorithm over a graph that does not have to fit in memory.
+        progress() << "Running STREAMING ORIGINAL algorithm" << '\n';
+        globalLoadOverlapped = true;
+        vector<int> pathTaken;
+        long long totalWeight = streamGreedy(args[2], pathTaken);
+        if (totalWeight < 0)
         {
-            outFile << pathTaken.at(i) << " ";
+            return 1;
+        };
+
+        // Write the output to a file
+        progress() << "Writing path to file" << '\n';
+        string fileName = "S[STREAM]" + to_string(totalWeight) + "_wcjunkins.sol";
+        if (!writePathFile(fileName, pathTaken))
+        {
+            cerr << "Failed to open the file for writing" << endl;
+            return 1;
         };
-        outFile << pathTaken.at(0) << " ";
-        outFile.close();
 
-        cout << "Total Distance: " << shortestDistance << endl;
+        progress() << "Total Distance: " << totalWeight << '\n';
 
-        cout << "The shortest path has been successfully generated" << endl
-             << "A copy of the complete path has been saved to the file " << fileName << endl
-             << "Closing program..." << endl;
+        progress() << "The shortest path has been successfully generated" << '\n'
+             << "A copy of the complete path has been saved to the file " << fileName << '\n'
+             << "Closing program..." << '\n';
+        printSummary("stream", pathTaken.size(), totalWeight, pathTaken, fileName);
 
         return 0;
     }
-    else if (strcmp(argv[1], "check") == 0)
+    else if (strcmp(args[1], "bench") == 0)
+    {
+        // Benchmark the solver modes on generated graphs.
+        progress() << "Running BENCHMARK of the solver modes" << '\n';
+        return runBench();
+    }
+    else if (strcmp(args[1], "generate") == 0)
+    {
+        // Write a generated graph to the file given as the second argument.
+        progress() << "Generating a graph" << '\n';
+        return runGenerate(args[2]);
+    }
+    else if (strcmp(args[1], "batch") == 0)
+    {
+        // Run every job in the manifest file in this one process.
+        progress() << "Running BATCH of jobs" << '\n';
+        return runBatch(args[2]);
+    }
+    else if (strcmp(args[1], "check") == 0)
     {
-        cout << "Checking the total distance of the path in the provided file" << endl;
+        progress() << "Checking the paths in the provided files" << '\n';
 
         // Read in the file.
-        ifstream file(argv[2]);
-        if (!file.is_open())
+        graph *myGraph = new graph();
+        if (!loadGraph(args[2], myGraph))
+        {
+            return 1;
+        };
+        globalLoadedTime = chrono::steady_clock::now();
+
+        // Check every path file given after the graph.
+        vector<string> fileNames(args.begin() + 3, args.end());
+        if (fileNames.empty())
         {
-            cerr << "File cannot be opened" << endl;
+            cerr << "Give the .sol files to check after the graph" << endl;
             return 1;
         };
+        return checkTours(myGraph, fileNames);
+    }
+    else if (strcmp(args[1], "improve") == 0)
+    {
+        // Improve the path in a .sol file with 2-opt and Or-opt moves.
+        progress() << "Improving the path in the provided file" << '\n';
         graph *myGraph = new graph();
-        string textLine;
-        int index = 0;
-        while (getline(file, textLine))
+        if (!loadGraph(args[2], myGraph))
         {
-            istringstream iss(textLine);
-            int weightToAdd;
-            while (iss >> weightToAdd)
-            {
-                myGraph->addWeight(index, weightToAdd);
-            };
-            index++;
+            return 1;
+        };
+        globalLoadedTime = chrono::steady_clock::now();
+        if (!readPathFile(args[3], myGraph->numNodes, myGraph->pathTaken))
+        {
+            return 1;
         };
-        file.close();
+        long long totalWeight = improveTour(myGraph, args[2], myGraph->pathTaken, "S[IMPROVED]");
+
+        // Write the output to a file
+        progress() << "Writing path to file" << '\n';
+        string fileName = "S[IMPROVED]" + to_string(totalWeight) + "_wcjunkins.sol";
+        if (!writePathFile(fileName, myGraph->pathTaken))
+        {
+            cerr << "Failed to open the file for writing" << endl;
+            return 1;
+        };
+
+        progress() << "Total Distance: " << totalWeight << '\n';
+
+        progress() << "The improved path has been successfully generated" << '\n'
+             << "A copy of the complete path has been saved to the file " << fileName << '\n'
+             << "Closing program..." << '\n';
+        printSummary("improve", myGraph->numNodes, totalWeight, myGraph->pathTaken, fileName);
 
-        // Go through the path file.
-        ifstream pathFile(argv[3]);
-        if (!pathFile.is_open())
+        return 0;
+    }
+    else if (strcmp(args[1], "convert") == 0)
+    {
+        // Convert a text graph file into the binary format. Every mode detects binary files and opens them without parsing.
+        progress() << "Converting the graph to the binary format" << '\n';
+        graph *myGraph = new graph();
+        if (!loadGraph(args[2], myGraph))
         {
-            cerr << "File cannot be opened" << endl;
             return 1;
         };
-        int totalWeight = 0;
-        int pathValue;
-        int initialPathValue;
-        pathFile >> initialPathValue;
-        while (pathFile >> pathValue)
+        globalLoadedTime = chrono::steady_clock::now();
+        if (myGraph->coordinates)
         {
-            totalWeight += myGraph->distance(initialPathValue, pathValue);
-            cout << initialPathValue << "---" << myGraph->distance(initialPathValue, pathValue) << "-->" << pathValue << endl;
-            initialPathValue = pathValue;
+            cerr << "Coordinate files have no matrix to convert; every mode reads them directly." << endl;
+            return 1;
+        };
+        string fileName = (args.size() > 3) ? args[3] : binaryGraphName(args[2]);
+        if (!writeBinaryGraph(myGraph, fileName))
+        {
+            cerr << "Failed to open the file for writing" << endl;
+            return 1;
         };
-        cout << "Total path distance: " << totalWeight << endl;
-        pathFile.close();
+        progress() << "The binary graph has been saved to the file " << fileName << '\n';
 
         return 0;
     }
     else
     {
         // Nothing of meaning was typed, or there was a typo.
-        cout << "Incorrect arguments. Type something like ./a.out programMode inputFile.ext pathToCheck.ext(if applicable)" << endl
-             << "Examples of programModes: {original, nearest, brute, check}." << endl
-             << "Try running the program again with those arguments." << endl;
+        cout << "Incorrect arguments. Type something like ./a.out programMode inputFile.ext pathToCheck.ext(if applicable)" << '\n'
+             << "Examples of programModes: {original, stream, nearest, brute, heldkarp, bnb, batch, bench, generate, check, improve, convert}." << '\n'
+             << "Try running the program again with those arguments." << '\n';
         return 0;
     };
 
     // Start the Original algorithm here:
     //  Read in the file.
-    cout << "Reading in the graph" << endl;
-    ifstream file(argv[2]);
-    if (!file.is_open())
+    progress() << "Reading in the graph" << '\n';
+    graph *myGraph = new graph();
+    progress() << "Parsing graph file" << '\n';
+    if (!loadGraph(args[2], myGraph))
     {
-        cerr << "File cannot be opened." << endl;
         return 1;
     };
-    cout << "Successfully opened the file" << endl;
-    graph *myGraph = new graph();
-    string textLine;
-    int index = 0;
-    cout << "Parsing graph file" << endl;
-    while (getline(file, textLine))
-    {
-        istringstream iss(textLine);
-        int weightToAdd;
-        while (iss >> weightToAdd)
-        {
-            myGraph->addWeight(index, weightToAdd);
-        };
-        node *newNode = new node(index);
-        myGraph->nodes.push_back(newNode);
-        index++;
-    };
-    file.close();
-    myGraph->numNodes = index;
-    cout << "Finished reading in the graph" << endl;
-    cout << "Sorting weight values" << endl;
-    myGraph->sortWeghts();
-    cout << "Successfully sorted weight values" << endl;
-
-    // Start with the smallest weight in the weights vector. Iterate through each weight in the vector.
-    for (int i = 0; i < myGraph->weights.size(); i++)
-    {
-        weight *currentWeight = myGraph->weights.at(i);
-        int currentLeftNodeNumber = myGraph->weights.at(i)->fromNode;
-        int currentRightNodeNumber = myGraph->weights.at(i)->toNode;
-        node *currentLeftNode = myGraph->nodes.at(currentLeftNodeNumber);
-        node *currentRightNode = myGraph->nodes.at(currentRightNodeNumber);
-
-        if ((currentLeftNode->nodeType == 0) && (currentRightNode->nodeType == 0))
-        {
-            // Both nodes are untouched.
-            // We will use this weight to connect those nodes. The nodes each become leader nodes. They are added to a group together.
-            cout << currentLeftNode->nodeName << "---" << currentWeight->value << "-->" << currentRightNode->nodeName << endl;
-            connectedNode *newConnectedNode = new connectedNode(currentLeftNode, currentRightNode);
-            myGraph->connectedNodes.push_back(newConnectedNode);
-            currentLeftNode->nodeType = 1;
-            currentRightNode->nodeType = 1;
-            currentLeftNode->nodeGroup = globalGroupNumber;
-            currentRightNode->nodeGroup = globalGroupNumber;
-            globalGroupNumber++;
-            globalTotalWeight += currentWeight->value;
-        }
-        else if ((currentLeftNode->nodeType == 2) && (currentRightNode->nodeType == 2))
-        {
-            // Both are inside nodes.
-            // We don't want to do anything.
-            continue;
-        }
-        else if ((currentLeftNode->nodeType == 1) && (currentRightNode->nodeType == 1))
-        {
-            // Both are leader nodes.
-            // We first need to check if they are in the same group.
-            if (currentLeftNode->nodeGroup != currentRightNode->nodeGroup)
-            {
-                // If they are not in the same group, connect the two nodes with the weight, set them as inside nodes, see which group between the two is the lowest integer, then go through the nodes vector and change all nodes with the higher-integer group into that of the lower-integer.
-                cout << currentLeftNode->nodeName << "---" << currentWeight->value << "-->" << currentRightNode->nodeName << endl;
-                connectedNode *newConnectedNode = new connectedNode(currentLeftNode, currentRightNode);
-                myGraph->connectedNodes.push_back(newConnectedNode);
-                globalTotalWeight += currentWeight->value;
-                currentLeftNode->nodeType = 2;
-                currentRightNode->nodeType = 2;
-                int smallestIntegerGroup;
-                int oldIntegerGroup;
-                if (currentLeftNode->nodeGroup < currentRightNode->nodeGroup)
-                {
-                    smallestIntegerGroup = currentLeftNode->nodeGroup;
-                    oldIntegerGroup = currentRightNode->nodeGroup;
-                }
-                else
-                {
-                    smallestIntegerGroup = currentRightNode->nodeGroup;
-                    oldIntegerGroup = currentLeftNode->nodeGroup;
-                };
-                for (int i = 0; i < myGraph->nodes.size(); i++)
-                {
-                    if (myGraph->nodes.at(i)->nodeGroup == oldIntegerGroup)
-                    {
-                        myGraph->nodes.at(i)->nodeGroup = smallestIntegerGroup;
-                    };
-                };
-            };
-        }
-        else if (((currentLeftNode->nodeType == 1) && (currentRightNode->nodeType == 2)) || ((currentLeftNode->nodeType == 2) && (currentRightNode->nodeType == 1)))
-        {
-            // One node is a leader and one is an inside node.
-            // We don't want to do anything.
-            continue;
-        }
-        else if (((currentLeftNode->nodeType == 2) && (currentRightNode->nodeType == 0)) || ((currentLeftNode->nodeType == 0) && (currentRightNode->nodeType == 2)))
-        {
-            // One node is an inside node and one is untouched.
-            // We don't want to do anything.
-            continue;
-        }
-        else
-        {
-            // One is a leader and one is untouched.
-            // We connect them. The leader becomes an inside node. The untouched node becomes a leader. The untouched node gets the group number of the leader.
-            cout << currentLeftNode->nodeName << "---" << currentWeight->value << "-->" << currentRightNode->nodeName << endl;
-            connectedNode *newConnectedNode = new connectedNode(currentLeftNode, currentRightNode);
-            myGraph->connectedNodes.push_back(newConnectedNode);
-            globalTotalWeight += currentWeight->value;
-            if (currentLeftNode->nodeType == 1)
-            {
-                // The left node was the leader.
-                currentLeftNode->nodeType = 2;
-                currentRightNode->nodeType = 1;
-                currentRightNode->nodeGroup = currentLeftNode->nodeGroup;
-            }
-            else
-            {
-                // The right node was the leader.
-                currentRightNode->nodeType = 2;
-                currentLeftNode->nodeType = 1;
-                currentLeftNode->nodeGroup = currentRightNode->nodeGroup;
-            };
-        };
-    };
-
-    // Connect the two end nodes. These will be the only leader nodes left.
-    bool oneUsed = false;
-    int nodeOne;
-    int nodeTwo;
-    for (int i = 0; i < myGraph->nodes.size(); i++)
+    globalLoadedTime = chrono::steady_clock::now();
+    progress() << "Finished reading in the graph" << '\n';
+    vector<int> path;
+    long long totalWeight = originalTour(myGraph, path);
+    if (totalWeight < 0)
     {
-        if (myGraph->nodes.at(i)->nodeType == 1)
-        {
-            if (!oneUsed)
-            {
-                nodeOne = myGraph->nodes.at(i)->nodeName;
-                oneUsed = true;
-            };
-            nodeTwo = myGraph->nodes.at(i)->nodeName;
-        };
+        return 1;
     };
-    node *currentLeftNode = myGraph->nodes.at(nodeOne);
-    node *currentRightNode = myGraph->nodes.at(nodeTwo);
-    connectedNode *newConnectedNode = new connectedNode(currentLeftNode, currentRightNode);
-    myGraph->connectedNodes.push_back(newConnectedNode);
-    globalTotalWeight += myGraph->distance(nodeOne, nodeTwo);
+    globalTotalWeight = totalWeight;
 
-    // Starting with nodeOne (the first remaining leader node), traverse through the connected nodes to retrace our path.
-    node *currentNode = currentLeftNode;
-    for (int i = 0; i < myGraph->numNodes; i++)
+    if (hasOption("improve"))
     {
-        for (int j = 0; j < myGraph->connectedNodes.size(); j++)
-        {
-            if (((myGraph->connectedNodes.at(j)->connectedLeftNode == currentNode) || (myGraph->connectedNodes.at(j)->connectedRightNode == currentNode)) && (myGraph->connectedNodes.at(j)->checked == false))
-            {
-                if (myGraph->connectedNodes.at(j)->connectedLeftNode == currentNode)
-                {
-                    myGraph->pathTaken.push_back(currentNode->nodeName);
-                    currentNode = myGraph->connectedNodes.at(j)->connectedRightNode;
-                }
-                else
-                {
-                    myGraph->pathTaken.push_back(currentNode->nodeName);
-                    currentNode = myGraph->connectedNodes.at(j)->connectedLeftNode;
-                };
-                myGraph->connectedNodes.at(j)->checked = true;
-            };
-        };
+        globalTotalWeight = improveTour(myGraph, args[2], path, "S");
     };
-    myGraph->pathTaken.push_back(currentLeftNode->nodeName);
+    path.push_back(path.at(0));
+    myGraph->pathTaken = path;
 
     // Write the output to a file
-    cout << "Writing path to file" << endl;
+    progress() << "Writing path to file" << '\n';
     string fileName = "S" + to_string(globalTotalWeight) + "_wcjunkins.sol";
-    ofstream outFile(fileName);
-    if (!outFile.is_open())
-    {
-        cerr << "Failed to open the file for writing" << endl;
-        return 1;
-    };
-    for (int i = 0; i <= myGraph->numNodes; i++)
     {
-        outFile << myGraph->pathTaken.at(i) << " ";
-        cout << myGraph->pathTaken.at(i) << " ";
+        scopedTimer timer("write tour");
+        ofstream outFile(fileName);
+        if (!outFile.is_open())
+        {
+            cerr << "Failed to open the file for writing" << endl;
+            return 1;
+        };
+        for (int i = 0; i <= myGraph->numNodes; i++)
+        {
+            outFile << myGraph->pathTaken.at(i) << " ";
+            progress() << myGraph->pathTaken.at(i) << " ";
+        };
+        outFile.close();
     };
-    outFile.close();
 
     // Ending total.
-    cout << endl
-         << "Total Distance: " << globalTotalWeight << endl;
+    progress() << '\n'
+         << "Total Distance: " << globalTotalWeight << '\n';
 
-    cout << "The shortest path has been successfully generated" << endl
-         << "A copy of the complete path has been saved to the file " << fileName << endl
-         << "Closing program..." << endl;
+    progress() << "The shortest path has been successfully generated" << '\n'
+         << "A copy of the complete path has been saved to the file " << fileName << '\n'
+         << "Closing program..." << '\n';
+    path.pop_back();
+    printSummary("original", myGraph->numNodes, globalTotalWeight, path, fileName);
 
     return 0;
 };
\ No newline at end of file
@@ -1,64 +1,198 @@
 #include <iostream>
+#include <fstream>
+#include <sstream>
 #include <string>
 #include <vector>
+#include <array>
+#include <utility>
+#include <climits>
 #include <cmath>
 #include <algorithm>
 using namespace std;
 
-const int numNodes = 4;
+// The largest graph the fixed-size solvers are compiled for.
+const int maxFixedNodes = 16;
+
+// A graph of N nodes, stored as a full matrix of edge weights.
+template <int N>
+using fixedGraph = array<array<int, N>, N>;
+
+// Rearranges the values into the next larger permutation and returns true, or returns false if they were already in their last permutation. It does the same as std::next_permutation, but it can run at compile time.
+template <typename T, size_t M>
+constexpr bool nextPermutation(array<T, M> &values)
+{
+    if (M < 2)
+    {
+        return false;
+    }
+    size_t i = M - 1;
+    while ((i > 0) && !(values[i - 1] < values[i]))
+    {
+        i--;
+    }
+    if (i == 0)
+    {
+        return false;
+    }
+    size_t j = M - 1;
+    while (!(values[i - 1] < values[j]))
+    {
+        j--;
+    }
+    T swapped = values[i - 1];
+    values[i - 1] = values[j];
+    values[j] = swapped;
+    for (size_t left = i, right = M - 1; left < right; left++, right--)
+    {
+        swapped = values[left];
+        values[left] = values[right];
+        values[right] = swapped;
+    }
+    return true;
+}
+
+// Adds up the weight of the path startingNode -> nodeBank[0] -> ... -> nodeBank[N - 2] -> startingNode. The index pack unrolls the sum, so there is no loop or bounds check left at run time.
+template <int N, size_t... I>
+constexpr int pathWeight(const fixedGraph<N> &myGraph, int startingNode, const array<int, N - 1> &nodeBank, index_sequence<I...>)
+{
+    return myGraph[startingNode][nodeBank[0]] + (0 + ... + myGraph[nodeBank[I]][nodeBank[I + 1]]) + myGraph[nodeBank[N - 2]][startingNode];
+}
 
 // A function to go through the graph and find the shortest path using multiple iterations of the naive brute force approach.
 // Inspiration from GeeksForGeeks.com
-int findMinimumPath(int myGraph[numNodes][numNodes], int startingNode)
+// The number of nodes is a template parameter, so everything lives in fixed-size arrays and the function can also run at compile time.
+template <int N>
+constexpr int findMinimumPath(const fixedGraph<N> &myGraph, int startingNode)
 {
-    // Other than the node that we are starting with, put all the other nodes into a vector nodeBank.
-    vector<int> nodeBank;
-    for (int i = 0; i < numNodes; i++)
+    if constexpr (N < 2)
     {
-        if (i != startingNode)
+        return 0;
+    }
+    else
+    {
+        // Other than the node that we are starting with, put all the other nodes into the array nodeBank, in increasing order.
+        array<int, N - 1> nodeBank{};
+        for (int i = 0, k = 0; i < N; i++)
         {
-            nodeBank.push_back(i);
+            if (i != startingNode)
+            {
+                nodeBank[k++] = i;
+            }
         }
+
+        // Try every order of the nodeBank and keep the shortest path. O(n!)
+        int minimumPath = INT_MAX;
+        do
+        {
+            int totalEdgeWeight = pathWeight<N>(myGraph, startingNode, nodeBank, make_index_sequence<N - 2>{});
+            if (totalEdgeWeight < minimumPath)
+            {
+                minimumPath = totalEdgeWeight;
+            }
+        } while (nextPermutation(nodeBank));
+
+        return minimumPath;
     }
+}
 
-    // Make our minimum path the largest integer we can have. This will reduce the liklihood of having a path greater than the initial minimumPath variable, which would screw up the algorithm.
-    int minimumPath = INT_MAX;
+// The example graph, solved while compiling.
+constexpr fixedGraph<4> exampleGraph = {{{0, 10, 15, 20},
+                                         {10, 0, 35, 25},
+                                         {15, 35, 0, 30},
+                                         {20, 25, 30, 0}}};
+static_assert(findMinimumPath<4>(exampleGraph, 0) == 80, "The shortest path of the example graph is 80");
 
-    // Go through one combination of paths to see if it is smaller than the previous minimumPath.
-    do
+// Copies a graph of weights into a fixed-size graph of N nodes and solves it, or moves on to the solver for N + 1 nodes if the graph has more nodes than that.
+template <int N>
+int solveFixedSize(const vector<vector<int>> &weights, int startingNode)
+{
+    if constexpr (N > maxFixedNodes)
     {
-        // Start fresh with a new totalEdgeWeight value.
-        int totalEdgeWeight = 0;
-
-        // Starting with the first node (the startingNode), which corresponds to a row in our graph matrix, go through every node in our nodeBank. The nodeBank holds each node OTHER THAN the starting node.
-        int row = startingNode;
-        for (int i = 0; i < nodeBank.size(); i++)
+        return -1;
+    }
+    else
+    {
+        if (weights.size() != N)
         {
-            // To totalEdgeWeight, add the value of the current row's (current node's) first connection to another node. This may not necessarily be the nearest neighbor to the current node. We are simply trying all combinations of nodes in a brute force manner. At the end of this iteration, we will find a new permutation of the nodeBank which will cause us to try different node paths on the next iteration.
-            totalEdgeWeight += myGraph[row][nodeBank[i]];
-            // Our new row will be the row to which we traveled.
-            row = nodeBank[i];
+            return solveFixedSize<N + 1>(weights, startingNode);
         }
-        // After going through each node in our path, find the weight of the edge between the last node we landed on to the original startingNode.
-        totalEdgeWeight += myGraph[row][startingNode];
-
-        // If the path we just forged is less than any previously recorded minimum path, then make that the new minimum path.
-        if (totalEdgeWeight < minimumPath)
+        fixedGraph<N> myGraph{};
+        for (int i = 0; i < N; i++)
         {
-            minimumPath = totalEdgeWeight;
+            for (int j = 0; j < N; j++)
+            {
+                myGraph[i][j] = weights[i][j];
+            }
         }
-    } while (next_permutation(nodeBank.begin(), nodeBank.end())); //Keep iterating through this as long as we can keep finding new permutations of nodeBank. When we no longer have any viable permutations, it returns false and stops the algorithm because we have searched all possible paths. O(n!)
+        return findMinimumPath<N>(myGraph, startingNode);
+    }
+}
 
-    return minimumPath;
+// Reads a graph file in the format of TSP.cpp (row i holds the weights from node i to nodes 0 through i) into a full matrix. Returns false (with a message) if the file cannot be read or a row does not hold exactly i + 1 non-negative integers, the last of them 0.
+bool readGraph(const char *fileName, vector<vector<int>> &weights)
+{
+    ifstream graphFile(fileName);
+    if (!graphFile.is_open())
+    {
+        cerr << "File cannot be opened" << endl;
+        return false;
+    }
+    vector<vector<int>> rows;
+    string line;
+    while (getline(graphFile, line))
+    {
+        istringstream lineStream(line);
+        vector<int> row;
+        int value;
+        while (lineStream >> value)
+        {
+            row.push_back(value);
+        }
+        bool malformed = !lineStream.eof();
+        if (row.empty() && !malformed)
+        {
+            continue;
+        }
+        size_t badRow = rows.size();
+        if (malformed || (row.size() != badRow + 1) || (*min_element(row.begin(), row.end()) < 0) || (row.back() != 0))
+        {
+            cerr << "Malformed graph file: row " << badRow << " should hold exactly " << badRow + 1 << " non-negative integers, ending with 0." << endl;
+            return false;
+        }
+        rows.push_back(row);
+    }
+    int numNodes = rows.size();
+    weights.assign(numNodes, vector<int>(numNodes, 0));
+    for (int i = 0; i < numNodes; i++)
+    {
+        for (int j = 0; j < i; j++)
+        {
+            weights[i][j] = rows[i][j];
+            weights[j][i] = rows[i][j];
+        }
+    }
+    return true;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
-    int myGraph[numNodes][numNodes] = {{0, 10, 15, 20},
-                                       {10, 0, 35, 25},
-                                       {15, 35, 0, 30},
-                                       {20, 25, 30, 0}};
+    // With no arguments, solve the example graph. Otherwise solve the graph file given as the first argument, which may have up to maxFixedNodes nodes.
     int startingNode = 0;
-    cout << findMinimumPath(myGraph, startingNode) << endl;
+    if (argc < 2)
+    {
+        cout << findMinimumPath<4>(exampleGraph, startingNode) << endl;
+        return 0;
+    }
+    vector<vector<int>> weights;
+    if (!readGraph(argv[1], weights))
+    {
+        return 1;
+    }
+    if (weights.empty() || (weights.size() > maxFixedNodes))
+    {
+        cerr << "The graph must have between 1 and " << maxFixedNodes << " nodes" << endl;
+        return 1;
+    }
+    cout << solveFixedSize<1>(weights, startingNode) << endl;
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,63 @@
+#!/bin/bash
+# Cross-checks the solvers of TSP.cpp on small seeded graphs, so that a change that breaks one of them is caught.
+# For every seed it generates a 10-node graph and checks that:
+#   brute, heldkarp, bnb and the standalone TSP_Brute_Force all find the same shortest distance,
+#   improve mode, run on the nearest neighbor path, returns a tour no shorter than that and no longer than the path it started from,
+#   check mode accepts every .sol file written and reports the distance in its name,
+#   batch mode finds the same distances as the single runs.
+# Usage: ./crossCheck.sh [seed ...] (seeds 1 2 3 by default). Builds into a temporary directory and exits with 1 on the first disagreement.
+
+seeds=${*:-1 2 3}
+repo=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+g++ -O2 -std=c++17 -pthread -o "$work/tsp" "$repo/TSP.cpp" || exit 1
+g++ -O2 -std=c++17 -o "$work/bruteForce" "$repo/TSP_Brute_Force.cpp" || exit 1
+
+# Prints the distance from a mode's --json summary.
+distance() {
+    sed -n 's/.*"distance": \([0-9-]*\).*/\1/p'
+}
+
+fail() {
+    echo "FAIL (seed $seed): $*"
+    exit 1
+}
+
+for seed in $seeds; do
+    dir="$work/seed$seed"
+    mkdir "$dir"
+    cd "$dir" || exit 1
+    "$work/tsp" generate g.graph --nodes=10 --seed="$seed" --quiet > /dev/null || fail "generate"
+
+    # The exact solvers must agree.
+    best=$("$work/bruteForce" g.graph)
+    for mode in brute heldkarp bnb; do
+        cost=$("$work/tsp" "$mode" g.graph --json | distance)
+        [ "$cost" = "$best" ] || fail "$mode found $cost, TSP_Brute_Force found $best"
+    done
+
+    # Improving the nearest neighbor path can only shorten it, and never below the optimum.
+    nearest=$("$work/tsp" nearest g.graph --json | distance)
+    improved=$("$work/tsp" improve g.graph "S[NEAREST]${nearest}_wcjunkins.sol" --json | distance)
+    [ -n "$improved" ] && [ "$improved" -ge "$best" ] && [ "$improved" -le "$nearest" ] || fail "improve turned $nearest into $improved (optimum $best)"
+
+    # Every tour written so far must pass check mode with the distance in its name.
+    "$work/tsp" check g.graph *_wcjunkins.sol --json > check.json || fail "check rejected a tour: $(cat check.json)"
+    for sol in *_wcjunkins.sol; do
+        named=${sol%_wcjunkins.sol}
+        named=${named##*[!0-9]}
+        grep -qF "{\"file\": \"$sol\", \"nodes\": 11, \"distance\": $named, \"status\": \"ok\"}" check.json || fail "check does not confirm $sol"
+    done
+
+    # Batch mode must find the same distances as the single runs.
+    printf 'g.graph brute\ng.graph heldkarp\ng.graph bnb\ng.graph nearest --improve\n' > manifest.txt
+    "$work/tsp" batch manifest.txt --quiet > /dev/null || fail "batch"
+    expected=$(printf '%s\n' "$best" "$best" "$best" "$improved")
+    batched=$(tail -n +2 batch_summary.csv | awk -F, '{ print $(NF - 4) }')
+    [ "$batched" = "$expected" ] || fail "batch found $(echo $batched), expected $(echo $expected)"
+
+    echo "seed $seed: optimum $best, nearest $nearest, improved $improved"
+done
+echo "All solvers agree"